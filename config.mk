@@ -1,8 +1,10 @@
 PROJECT = kranewm
 BAR = kranebar
 CLIENT = kranec
+TEST = kranetest
+BENCH = kranebench
 
-DEPENDENCIES = x11 xinerama xres libprocps spdlog
+DEPENDENCIES = x11 x11-xcb xcb xcb-sync xext xinerama xrandr xres spdlog
 
 OBJDIR = obj
 SRCDIR = src
@@ -25,14 +27,29 @@ WINSYS_OBJ_FILES := $(patsubst src/winsys/%.cc,obj/winsys/%.o,${WINSYS_SRC_FILES
 X_DATA_SRC_FILES := $(wildcard src/winsys/xdata/*.cc)
 X_DATA_OBJ_FILES := $(patsubst src/winsys/xdata/%.cc,obj/winsys/xdata/%.o,${X_DATA_SRC_FILES})
 
-WINSYS_LINK_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES}
+MOCK_SRC_FILES := $(wildcard src/winsys/mock/*.cc)
+MOCK_OBJ_FILES := $(patsubst src/winsys/mock/%.cc,obj/winsys/mock/%.o,${MOCK_SRC_FILES})
+
+TEST_SRC_FILES := $(wildcard src/test/*.cc)
+TEST_OBJ_FILES := $(patsubst src/test/%.cc,obj/test/%.o,${TEST_SRC_FILES})
+
+BENCH_SRC_FILES := $(wildcard src/bench/*.cc)
+BENCH_OBJ_FILES := $(patsubst src/bench/%.cc,obj/bench/bench/%.o,${BENCH_SRC_FILES})
+
+MODEL_OBJ_FILES := $(filter-out obj/core/main.o,${CORE_OBJ_FILES})
+
+WINSYS_LINK_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${MOCK_OBJ_FILES}
 BAR_LINK_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${BAR_OBJ_FILES}
 CLIENT_LINK_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${CLIENT_OBJ_FILES}
 CORE_LINK_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${CORE_OBJ_FILES}
+TEST_LINK_FILES := ${WINSYS_OBJ_FILES} ${MOCK_OBJ_FILES} ${MODEL_OBJ_FILES} ${TEST_OBJ_FILES}
+# the benchmark is built with release flags into a tree of its own under
+# obj/bench, so that it never links against sanitized debug objects
+BENCH_LINK_FILES := $(patsubst obj/%,obj/bench/%,${WINSYS_OBJ_FILES} ${MODEL_OBJ_FILES} obj/test/allocations.o) ${BENCH_OBJ_FILES}
 
 H_FILES := $(shell find $(SRCDIR) -name '*.hh')
 SRC_FILES := $(shell find $(SRCDIR) -name '*.cc')
-OBJ_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${CORE_OBJ_FILES}
+OBJ_FILES := ${WINSYS_OBJ_FILES} ${X_DATA_OBJ_FILES} ${MOCK_OBJ_FILES} ${CORE_OBJ_FILES} ${TEST_OBJ_FILES} ${BENCH_LINK_FILES}
 DEPS = $(OBJ_FILES:%.o=%.d)
 
 SANFLAGS = -fsanitize=undefined -fsanitize=address -fsanitize-address-use-after-scope
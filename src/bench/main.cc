@@ -0,0 +1,192 @@
+#include "../core/client.hh"
+#include "../core/layout.hh"
+#include "../test/allocations.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Times LayoutHandler::arrange for every layout kind over a range of client
+// counts and screen regions, with gaps and margins off and on, and reports
+// the time and the number of heap allocations per call.
+
+static constexpr LayoutHandler::LayoutKind LAYOUT_KINDS[] = {
+    LayoutHandler::LayoutKind::Float,
+    LayoutHandler::LayoutKind::FramelessFloat,
+    LayoutHandler::LayoutKind::SingleFloat,
+    LayoutHandler::LayoutKind::FramelessSingleFloat,
+    LayoutHandler::LayoutKind::Center,
+    LayoutHandler::LayoutKind::Monocle,
+    LayoutHandler::LayoutKind::MainDeck,
+    LayoutHandler::LayoutKind::StackDeck,
+    LayoutHandler::LayoutKind::DoubleDeck,
+    LayoutHandler::LayoutKind::Paper,
+    LayoutHandler::LayoutKind::CompactPaper,
+    LayoutHandler::LayoutKind::DoubleStack,
+    LayoutHandler::LayoutKind::CompactDoubleStack,
+    LayoutHandler::LayoutKind::HorizontalStack,
+    LayoutHandler::LayoutKind::CompactHorizontalStack,
+    LayoutHandler::LayoutKind::VerticalStack,
+    LayoutHandler::LayoutKind::CompactVerticalStack,
+};
+
+static constexpr const char* LAYOUT_NAMES[] = {
+    "Float",
+    "FramelessFloat",
+    "SingleFloat",
+    "FramelessSingleFloat",
+    "Center",
+    "Monocle",
+    "MainDeck",
+    "StackDeck",
+    "DoubleDeck",
+    "Paper",
+    "CompactPaper",
+    "DoubleStack",
+    "CompactDoubleStack",
+    "HorizontalStack",
+    "CompactHorizontalStack",
+    "VerticalStack",
+    "CompactVerticalStack",
+};
+
+static constexpr std::size_t CLIENT_COUNTS[] = {
+    1, 2, 3, 5, 10, 20, 50, 100, 200, 500, 1000
+};
+
+static constexpr winsys::Dim REGION_DIMS[] = {
+    winsys::Dim { 1366, 768 },
+    winsys::Dim { 1920, 1080 },
+    winsys::Dim { 3840, 2160 },
+};
+
+static constexpr int GAP_SIZE = 10;
+static constexpr int MARGIN = 20;
+
+// larger than any gap size or margin a layout accepts
+static constexpr int CLEAR = 1 << 16;
+
+// every measurement is repeated until it has run for at least this long
+static constexpr std::chrono::nanoseconds MIN_DURATION = std::chrono::milliseconds(2);
+
+struct Measurement final
+{
+    double ns_per_arrange;
+    double allocations_per_arrange;
+};
+
+static Measurement
+measure(
+    LayoutHandler const& layout_handler,
+    winsys::Region region,
+    std::vector<Client_ptr> const& clients,
+    std::vector<Placement>& placements
+)
+{
+    std::size_t iterations = 1;
+
+    for (;;) {
+        std::size_t allocations = allocation_count();
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < iterations; ++i) {
+            placements.clear();
+            layout_handler.arrange(region, placements, clients.cbegin(), clients.cend());
+        }
+
+        auto duration = std::chrono::steady_clock::now() - start;
+        allocations = allocation_count() - allocations;
+
+        if (duration >= MIN_DURATION)
+            return Measurement {
+                static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+                ) / iterations,
+                static_cast<double>(allocations) / iterations
+            };
+
+        iterations *= 2;
+    }
+}
+
+int
+main(int, char **)
+{
+    std::size_t max_clients = CLIENT_COUNTS[std::size(CLIENT_COUNTS) - 1];
+
+    std::vector<Client_ptr> all_clients;
+    all_clients.reserve(max_clients);
+
+    for (std::size_t i = 0; i < max_clients; ++i) {
+        Client_ptr client = new Client(
+            i + 1, i + 1 + max_clients,
+            "", "", "",
+            nullptr, nullptr, nullptr,
+            std::nullopt, std::nullopt
+        );
+
+        client->free_region = winsys::Region {
+            winsys::Pos { static_cast<int>(i % 100) * 10, static_cast<int>(i % 50) * 10 },
+            winsys::Dim { 640, 480 }
+        };
+
+        all_clients.push_back(client);
+    }
+
+    all_clients.front()->focus();
+
+    std::vector<Client_ptr> clients;
+    clients.reserve(max_clients);
+
+    std::vector<Placement> placements;
+    placements.reserve(max_clients);
+
+    std::printf(
+        "%-24s %8s %11s %6s %14s %12s\n",
+        "layout", "clients", "region", "gaps", "ns/arrange", "allocs/call"
+    );
+
+    for (std::size_t k = 0; k < std::size(LAYOUT_KINDS); ++k)
+        for (bool spaced : { false, true }) {
+            LayoutHandler layout_handler;
+            layout_handler.set_kind(LAYOUT_KINDS[k]);
+
+            // clamped to zero first, so that gaps and margins are exactly
+            // off, or exactly the benchmarked sizes
+            layout_handler.change_gap_size(-CLEAR);
+            layout_handler.change_margin(-CLEAR);
+
+            if (spaced) {
+                layout_handler.change_gap_size(GAP_SIZE);
+                layout_handler.change_margin(MARGIN);
+            }
+
+            for (winsys::Dim dim : REGION_DIMS)
+                for (std::size_t count : CLIENT_COUNTS) {
+                    clients.assign(all_clients.begin(), all_clients.begin() + count);
+
+                    Measurement measurement = measure(
+                        layout_handler,
+                        winsys::Region { winsys::Pos { 0, 0 }, dim },
+                        clients,
+                        placements
+                    );
+
+                    std::printf(
+                        "%-24s %8zu %5dx%-5d %6s %14.1f %12.2f\n",
+                        LAYOUT_NAMES[k],
+                        count,
+                        dim.w, dim.h,
+                        spaced ? "on" : "off",
+                        measurement.ns_per_arrange,
+                        measurement.allocations_per_arrange
+                    );
+                }
+        }
+
+    for (Client_ptr client : all_clients)
+        delete client;
+
+    return 0;
+}
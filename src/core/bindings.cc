@@ -0,0 +1,63 @@
+#include "bindings.hh"
+
+BindingTable::BindingTable(KeyBindings const& key_bindings, MouseBindings const& mouse_bindings)
+    : m_key_actions({}),
+      m_mouse_actions({}),
+      m_key_slots(winsys::KEY_COUNT * MODIFIER_COMBINATIONS, 0),
+      m_mouse_slots({})
+{
+    m_key_actions.reserve(key_bindings.size());
+    m_mouse_actions.reserve(mouse_bindings.size());
+
+    for (auto const& [input, action] : key_bindings) {
+        m_key_actions.push_back(&action);
+        m_key_slots[key_slot(input)]
+            = static_cast<std::uint16_t>(m_key_actions.size());
+    }
+
+    for (auto const& [input, action] : mouse_bindings) {
+        m_mouse_actions.push_back(&action);
+        m_mouse_slots[mouse_slot(input)]
+            = static_cast<std::uint16_t>(m_mouse_actions.size());
+    }
+}
+
+KeyAction const*
+BindingTable::find(winsys::KeyInput const& input) const
+{
+    std::uint16_t slot = m_key_slots[key_slot(input)];
+    return slot ? m_key_actions[slot - 1] : nullptr;
+}
+
+MouseAction const*
+BindingTable::find(winsys::MouseInput const& input) const
+{
+    std::uint16_t slot = m_mouse_slots[mouse_slot(input)];
+    return slot ? m_mouse_actions[slot - 1] : nullptr;
+}
+
+std::size_t
+BindingTable::modifier_index(winsys::EnumSet<winsys::Modifier> modifiers)
+{
+    static constexpr winsys::EnumSet<winsys::Modifier> locks{
+        winsys::Modifier::NumLock,
+        winsys::Modifier::ScrollLock
+    };
+
+    return modifiers.bits() & ~locks.bits();
+}
+
+std::size_t
+BindingTable::key_slot(winsys::KeyInput const& input)
+{
+    return static_cast<std::size_t>(input.key) * MODIFIER_COMBINATIONS
+        + modifier_index(input.modifiers);
+}
+
+std::size_t
+BindingTable::mouse_slot(winsys::MouseInput const& input)
+{
+    return ((static_cast<std::size_t>(input.target) * BUTTON_COUNT)
+            + static_cast<std::size_t>(input.button)) * MODIFIER_COMBINATIONS
+        + modifier_index(input.modifiers);
+}
@@ -4,8 +4,12 @@
 #include "../winsys/input.hh"
 #include "client.hh"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
+#include <vector>
 
 class Model;
 
@@ -25,4 +29,39 @@ typedef
     std::unordered_map<winsys::MouseInput, MouseAction>
     MouseBindings;
 
+// The bindings, compiled into flat tables indexed by key or (target, button)
+// and the bound modifiers, with lock modifiers masked out. The table refers
+// to the actions held by the binding maps it was built from, which must
+// outlive it.
+class BindingTable final
+{
+public:
+    BindingTable(KeyBindings const&, MouseBindings const&);
+
+    BindingTable(const BindingTable&) = delete;
+    BindingTable& operator=(const BindingTable&) = delete;
+
+    KeyAction const* find(winsys::KeyInput const&) const;
+    MouseAction const* find(winsys::MouseInput const&) const;
+
+private:
+    static constexpr std::size_t MODIFIER_COMBINATIONS = 1 << 5;
+    static constexpr std::size_t TARGET_COUNT
+        = static_cast<std::size_t>(winsys::MouseInput::MouseInputTarget::Client) + 1;
+    static constexpr std::size_t BUTTON_COUNT
+        = static_cast<std::size_t>(winsys::Button::Forward) + 1;
+
+    // slots hold an index into the action lists, offset by one so that a
+    // zero slot is unbound
+    std::vector<KeyAction const*> m_key_actions;
+    std::vector<MouseAction const*> m_mouse_actions;
+    std::vector<std::uint16_t> m_key_slots;
+    std::array<std::uint16_t, TARGET_COUNT * BUTTON_COUNT * MODIFIER_COMBINATIONS> m_mouse_slots;
+
+    static std::size_t modifier_index(winsys::EnumSet<winsys::Modifier>);
+    static std::size_t key_slot(winsys::KeyInput const&);
+    static std::size_t mouse_slot(winsys::MouseInput const&);
+
+};
+
 #endif//__BINDINGS_H_GUARD__
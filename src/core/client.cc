@@ -27,6 +27,7 @@ Client::Client(
       active_region({}),
       previous_region({}),
       inner_region({}),
+      committed_dim(std::nullopt),
       tile_decoration(winsys::Decoration::FREE_DECORATION),
       free_decoration(winsys::Decoration::FREE_DECORATION),
       active_decoration(winsys::Decoration::FREE_DECORATION),
@@ -51,6 +52,10 @@ Client::Client(
       disowned(false),
       producing(true),
       attaching(false),
+      sync_request(false),
+      sync_held(false),
+      name_dirty(false),
+      class_dirty(false),
       pid(pid),
       ppid(ppid),
       last_touched(std::chrono::steady_clock::now()),
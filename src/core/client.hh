@@ -96,6 +96,7 @@ typedef struct Client final
     winsys::Region active_region;
     winsys::Region previous_region;
     winsys::Region inner_region;
+    std::optional<winsys::Dim> committed_dim;
     winsys::Decoration tile_decoration;
     winsys::Decoration free_decoration;
     winsys::Decoration active_decoration;
@@ -120,6 +121,10 @@ typedef struct Client final
     bool disowned;
     bool producing;
     bool attaching;
+    bool sync_request;
+    bool sync_held;
+    bool name_dirty;
+    bool class_dirty;
     std::optional<winsys::Pid> pid;
     std::optional<winsys::Pid> ppid;
     std::chrono::time_point<std::chrono::steady_clock> last_touched;
@@ -4,6 +4,7 @@
 #include "../winsys/common.hh"
 #include "../winsys/geometry.hh"
 
+#include <algorithm>
 #include <cstdlib>
 #include <deque>
 #include <vector>
@@ -12,7 +12,7 @@
 
 class LayoutHandler final
 {
-    typedef std::deque<Client_ptr>::const_iterator client_iter;
+    typedef std::vector<Client_ptr>::const_iterator client_iter;
     typedef std::vector<Placement>& placement_vector;
 
 public:
@@ -1,14 +1,24 @@
 #include <iostream>
+#include <memory>
+#include <string_view>
 
+#include "../winsys/xdata/xcbconnection.hh"
 #include "../winsys/xdata/xconnection.hh"
 #include "defaults.hh"
 #include "model.hh"
 
 int
-main(int, char **)
+main(int argc, char ** argv)
 {
-    XConnection conn{ WM_NAME };
-    Model model(conn);
+    std::unique_ptr<winsys::Connection> conn;
+
+    // window queries are pipelined through xcb, unless plain Xlib is asked for
+    if (argc > 1 && std::string_view(argv[1]) == "--xlib")
+        conn = std::make_unique<XConnection>(WM_NAME);
+    else
+        conn = std::make_unique<XCBConnection>(WM_NAME);
+
+    Model model(*conn);
     model.run();
     return 0;
 }
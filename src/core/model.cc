@@ -4,6 +4,7 @@
 #include "model.hh"
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
@@ -11,11 +12,12 @@
 #include <functional>
 #include <set>
 #include <sstream>
-#include <thread>
 #include <unordered_set>
 #include <vector>
 
 extern "C" {
+#include <signal.h>
+#include <sys/signalfd.h>
 #include <sys/wait.h>
 #include <unistd.h>
 }
@@ -28,10 +30,10 @@ extern "C" {
 
 using namespace winsys;
 
-static Model* g_instance;
-
 Model::Model(Connection& conn)
     : m_conn(conn),
+      m_spawner(),
+      m_processes(),
       m_running(true),
       m_partitions({}, true),
       m_contexts({}, true),
@@ -42,19 +44,34 @@ Model::Model(Connection& conn)
       mp_prev_partition(nullptr),
       mp_prev_context(nullptr),
       mp_prev_workspace(nullptr),
-      mp_attachment(std::atomic(nullptr)),
+      mp_attachment(nullptr),
+      m_attachment_timer(std::nullopt),
       m_move_buffer(Buffer::BufferKind::Move),
       m_resize_buffer(Buffer::BufferKind::Resize),
+      m_pending_motion(std::nullopt),
+      m_motion_timer(std::nullopt),
+      m_motion_interval(0),
       m_stack({}),
       m_order({}),
+      m_client_list({}),
+      m_stacking_clients({}),
       m_client_map({}),
       m_pid_map({}),
+      m_spawned_pids({}),
       m_fullscreen_map({}),
       m_leader_map({}),
       m_sticky_clients({}),
       m_unmanaged_windows({}),
       mp_focus(nullptr),
       mp_jumped_from(nullptr),
+      m_dirty_layouts({}),
+      m_dirty_stacks({}),
+      m_coalesced_arrangements(0),
+      m_focus_deferred(false),
+      m_pending_offsets({}),
+      m_sync_timeouts({}),
+      m_signal_fd(-1),
+      m_timers(),
       m_key_bindings({
 #define CALL(args) [](Model& model) {model.args;}
           { { Key::Q, { Main, Ctrl, Shift } },
@@ -795,13 +812,14 @@ Model::Model(Connection& conn)
              }
           },
       }),
+      m_bindings(m_key_bindings, m_mouse_bindings),
       m_config()
 {
 #ifdef DEBUG
     spdlog::set_level(spdlog::level::debug);
 #endif
 
-    g_instance = this;
+    const auto start = std::chrono::steady_clock::now();
 
     static const std::vector<std::string> context_names{
         "a", "b", "c", "d", "e", "f", "g", "h", "i", "j"
@@ -832,7 +850,14 @@ Model::Model(Connection& conn)
     if constexpr (Config::ipc_enabled)
         m_conn.init_wm_ipc();
 
+    init_signals();
+    m_conn.watch_fd(m_timers.fd(), [this]() { m_timers.expire(); });
+
+    if (m_processes.fd() != -1)
+        m_conn.watch_fd(m_processes.fd(), [this]() { m_processes.process_events(); });
+
     acquire_partitions();
+    update_motion_interval();
 
     std::vector<std::string> desktop_names;
     desktop_names.reserve(m_workspaces.size());
@@ -877,8 +902,14 @@ Model::Model(Connection& conn)
 
     m_conn.grab_bindings(key_inputs, mouse_inputs);
 
-    for (Window window : m_conn.top_level_windows())
-        manage(window, !m_conn.must_manage_window(window), true);
+    adopt_windows();
+
+    spdlog::info(
+        "started up in {}ms",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count()
+    );
 
     if constexpr (!Config::debugging) {
         spawn_external(m_config.directory + m_config.blocking_autostart);
@@ -912,54 +943,90 @@ Model::~Model()
     m_contexts.clear();
     m_workspaces.clear();
     m_client_map.clear();
+
+    close(m_signal_fd);
 }
 
 
 void
 Model::run()
 {
+    flush_arrangements();
+
     while (m_running)
-        if constexpr (Config::ipc_enabled) {
-            if (m_conn.check_progress()) {
-                // process IPC message
-                m_conn.process_messages(
-                    [=,this](winsys::Message message) {
-                        std::visit(m_message_visitor, message);
-                    }
-                );
-
-                // process windowing system event
-                m_conn.process_events(
-                    [=,this](winsys::Event event) {
-                        std::visit(m_event_visitor, event);
-                    }
-                );
-            }
-        } else
-            std::visit(m_event_visitor, m_conn.step());
+        step();
 }
 
-
 void
-Model::init_signals() const
+Model::step()
 {
-    struct sigaction child_sa, exit_sa, ignore_sa;
+    // signals and timers are handled while waiting for progress
+    if (m_conn.check_progress() && m_running) {
+        // process windowing system events, input ahead of everything else
+        m_conn.process_events(m_process_event);
+
+        // process IPC message
+        if constexpr (Config::ipc_enabled)
+            m_conn.process_messages(m_process_message);
+    }
+
+    flush_arrangements();
+}
 
-    std::memset(&child_sa, 0, sizeof(child_sa));
-    child_sa.sa_handler = &Model::wait_children;
 
-    std::memset(&exit_sa, 0, sizeof(exit_sa));
-    exit_sa.sa_handler = &Model::handle_signal;
+void
+Model::init_signals()
+{
+    struct sigaction ignore_sa;
 
     std::memset(&ignore_sa, 0, sizeof(ignore_sa));
     ignore_sa.sa_handler = SIG_IGN;
-
-    sigaction(SIGCHLD, &child_sa,  NULL);
-    sigaction(SIGINT,  &exit_sa,   NULL);
-    sigaction(SIGHUP,  &exit_sa,   NULL);
-    sigaction(SIGINT,  &exit_sa,   NULL);
-    sigaction(SIGTERM, &exit_sa,   NULL);
     sigaction(SIGPIPE, &ignore_sa, NULL);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGTERM);
+
+    // the signals are consumed synchronously from the event loop
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+        Util::die("unable to block signals");
+
+    m_signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    if (m_signal_fd == -1)
+        Util::die("unable to create signalfd");
+
+    m_conn.watch_fd(m_signal_fd, [this]() { handle_signals(); });
+}
+
+void
+Model::handle_signals()
+{
+    struct signalfd_siginfo info;
+    bool children = false;
+
+    while (read(m_signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        switch (info.ssi_signo) {
+        case SIGCHLD: children = true; break;
+        case SIGINT:  // fallthrough
+        case SIGHUP:  // fallthrough
+        case SIGTERM:
+        {
+            if (m_running)
+                exit();
+
+            break;
+        }
+        default: break;
+        }
+    }
+
+    // pending SIGCHLDs coalesce, so every terminated child is reaped
+    if (children)
+        while (waitpid(-1, 0, WNOHANG) > 0);
 }
 
 // window management actions
@@ -1143,6 +1210,9 @@ Model::search_client(SearchSelector const& selector)
 bool
 Model::client_matches_search(Client_ptr client, SearchSelector const& selector) const
 {
+    if (selector.criterium() != SearchSelector::SelectionCriterium::OnWorkspaceBySelector)
+        refresh_client_properties(client);
+
     switch (selector.criterium()) {
     case SearchSelector::SelectionCriterium::OnWorkspaceBySelector:
     {
@@ -1191,6 +1261,23 @@ Model::client_matches_search(Client_ptr client, SearchSelector const& selector)
     return false;
 }
 
+void
+Model::refresh_client_properties(Client_ptr client) const
+{
+    // property changes only mark a client; its strings are not read back
+    // until something actually looks at them
+    if (client->name_dirty) {
+        client->name = m_conn.get_icccm_window_name(client->window);
+        client->name_dirty = false;
+    }
+
+    if (client->class_dirty) {
+        client->class_ = m_conn.get_icccm_window_class(client->window);
+        client->instance = m_conn.get_icccm_window_instance(client->window);
+        client->class_dirty = false;
+    }
+}
+
 
 Partition_ptr
 Model::active_partition() const
@@ -1251,6 +1338,47 @@ Model::is_free(Client_ptr client) const
                )->layout_is_free());
 }
 
+bool
+Model::is_placed(Placement const& placement) const
+{
+    Client_ptr client = placement.client;
+
+    if (client->active_decoration != placement.decoration)
+        return false;
+
+    switch (placement.method) {
+    case Placement::PlacementMethod::Free:
+    {
+        if (client->free_decoration != placement.decoration)
+            return false;
+
+        if (!placement.region)
+            return !client->mapped;
+
+        return client->mapped
+            && client->free_region == *placement.region
+            && client->active_region == *placement.region;
+    }
+    case Placement::PlacementMethod::Tile:
+    {
+        if (client->tile_decoration != placement.decoration
+            || client->free_decoration != Decoration::FREE_DECORATION)
+        {
+            return false;
+        }
+
+        if (!placement.region)
+            return !client->mapped;
+
+        return client->mapped
+            && client->tile_region == *placement.region
+            && client->active_region == *placement.region;
+    }
+    }
+
+    return false;
+}
+
 void
 Model::place_client(Placement& placement)
 {
@@ -1292,11 +1420,53 @@ Model::place_client(Placement& placement)
     }
 
     map_client(client);
+    commit_placement(client);
+}
+
+void
+Model::commit_placement(Client_ptr client)
+{
+    static constexpr std::chrono::milliseconds sync_timeout{100};
+
+    // a client that takes part in _NET_WM_SYNC_REQUEST is resized only once
+    // it has repainted for its previous size; meanwhile, the latest placement
+    // is held back and committed as soon as the client catches up
+    if (client->sync_request && client->committed_dim != client->inner_region.dim) {
+        if (m_sync_timeouts.count(client)) {
+            client->sync_held = true;
+            return;
+        }
+
+        m_conn.send_sync_request(client->window);
+        m_sync_timeouts[client] = m_timers.schedule(
+            sync_timeout,
+            [=,this]() {
+                spdlog::debug("sync request to {:#x} timed out", client->window);
+                m_sync_timeouts.erase(client);
+
+                if (client->sync_held)
+                    commit_placement(client);
+            }
+        );
+    }
+
+    client->sync_held = false;
+    client->committed_dim = client->inner_region.dim;
+
     m_conn.place_window(client->window, client->inner_region);
     m_conn.place_window(client->frame, client->active_region);
 
     render_decoration(client);
-    m_conn.update_window_offset(client->window, client->frame);
+
+    // the root-relative geometry of the client window, as conveyed to it by
+    // a synthetic ConfigureNotify once the current event batch is handled
+    m_pending_offsets[client->window] = Region {
+        Pos {
+            client->active_region.pos.x + client->inner_region.pos.x,
+            client->active_region.pos.y + client->inner_region.pos.y
+        },
+        client->inner_region.dim
+    };
 }
 
 void
@@ -1332,7 +1502,6 @@ Model::focus_client(Client_ptr client)
         set_iconify_client(Toggle::Off, client);
 
     unfocus_client(mp_focus);
-    m_conn.ungrab_buttons(client->frame);
 
     client->focus();
     client->urgent = false;
@@ -1343,7 +1512,10 @@ Model::focus_client(Client_ptr client)
     if (mp_workspace->layout_is_persistent() || mp_workspace->layout_is_single())
         apply_layout(mp_workspace);
 
-    if (m_conn.get_focused_window() != client->window)
+    // an unmapped client cannot receive input focus until it is arranged
+    if (!client->mapped)
+        m_focus_deferred = true;
+    else if (m_conn.get_focused_window() != client->window)
         m_conn.focus_window(client->window);
 
     render_decoration(client);
@@ -1357,7 +1529,6 @@ Model::unfocus_client(Client_ptr client)
         return;
 
     client->unfocus();
-    m_conn.regrab_buttons(client->frame);
     render_decoration(client);
 }
 
@@ -1378,18 +1549,17 @@ Model::sync_focus()
 void
 Model::attach_next_client()
 {
-    static std::atomic<unsigned> count{ 0 };
-    static auto attachment_resetter = [&,this]() mutable {
-        unsigned current = ++count;
+    if (m_attachment_timer)
+        m_timers.cancel(*m_attachment_timer);
 
-        std::this_thread::sleep_for(std::chrono::seconds(30));
-
-        if (current == count)
-            mp_attachment.exchange(nullptr);
-    };
-
-    mp_attachment.exchange(mp_workspace);
-    std::thread(attachment_resetter).detach();
+    mp_attachment = mp_workspace;
+    m_attachment_timer = m_timers.schedule(
+        std::chrono::seconds(30),
+        [this]() {
+            mp_attachment = nullptr;
+            m_attachment_timer = std::nullopt;
+        }
+    );
 }
 
 
@@ -1672,14 +1842,50 @@ Model::render_decoration(Client_ptr client)
 
 
 void
-Model::manage(const Window window, const bool ignore, const bool may_map)
+Model::adopt_windows()
+{
+    static constexpr std::size_t batch_size = 64;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<Window> windows = m_conn.top_level_windows();
+    std::vector<Window> batch;
+    batch.reserve(batch_size);
+
+    // the properties of a batch of windows are requested all at once, and
+    // every client is in place before the first arrangement is performed
+    for (std::size_t i = 0; i < windows.size(); i += batch_size) {
+        batch.assign(
+            windows.begin() + i,
+            windows.begin() + std::min(i + batch_size, windows.size())
+        );
+
+        for (WindowSnapshot const& snapshot : m_conn.fetch_window_snapshots(batch))
+            manage(snapshot, !snapshot.manageable, true);
+    }
+
+    flush_arrangements();
+
+    spdlog::info(
+        "adopted {} clients out of {} windows in {}ms",
+        m_client_list.size(),
+        windows.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count()
+    );
+}
+
+void
+Model::manage(WindowSnapshot const& snapshot, const bool ignore, const bool may_map)
 {
     static std::unordered_map<std::string, Rules> default_rules_memoized{};
 
-    std::optional<Region> window_geometry = m_conn.get_window_geometry(window);
+    const Window window = snapshot.window;
+    std::optional<Region> window_geometry = snapshot.geometry;
 
     if (ignore || !window_geometry) {
-        if (may_map && m_conn.window_is_mappable(window))
+        if (may_map && snapshot.mappable)
             m_conn.map_window(window);
 
         m_conn.init_unmanaged(window);
@@ -1688,11 +1894,24 @@ Model::manage(const Window window, const bool ignore, const bool may_map)
         return;
     }
 
-    std::optional<Pid> pid = m_conn.get_window_pid(window);
-    std::optional<Pid> ppid = m_conn.get_ppid(pid);
+    // exits not yet seen could leave stale parents in the process tree, or
+    // stale PIDs among those spawned
+    m_processes.process_events();
+    prune_spawned_pids();
 
-    while (ppid && m_pid_map.count(*ppid) == 0)
-        ppid = m_conn.get_ppid(ppid);
+    std::optional<Pid> pid = snapshot.pid;
+    std::optional<Pid> ppid = pid ? m_processes.parent(*pid) : std::nullopt;
+
+    // processes launched by the window manager descend from the spawner, or
+    // from a process it reported, where the search for a producing client can
+    // stop, unless that process is a client itself
+    while (ppid
+        && *ppid != m_spawner.pid()
+        && m_pid_map.count(*ppid) == 0
+        && m_spawned_pids.count(*ppid) == 0)
+    {
+        ppid = m_processes.parent(*ppid);
+    }
 
     Client_ptr producer = nullptr;
 
@@ -1703,40 +1922,38 @@ Model::manage(const Window window, const bool ignore, const bool may_map)
             producer = *ppid_client;
     }
 
-    std::string name = m_conn.get_icccm_window_name(window);
-    std::string class_ = m_conn.get_icccm_window_class(window);
-    std::string instance = m_conn.get_icccm_window_instance(window);
+    std::string const& name = snapshot.name;
+    std::string const& class_ = snapshot.class_;
+    std::string const& instance = snapshot.instance;
 
     std::string client_handle = name
         + ":" + class_
         + ":" + instance;
 
-    std::unordered_set<WindowType> types = m_conn.get_window_types(window);
-    std::unordered_set<WindowState> states = m_conn.get_window_states(window);
+    EnumSet<WindowState> const& states = snapshot.states;
 
     Region geometry = *window_geometry;
 
     Window frame = m_conn.create_frame(geometry);
 
     bool center = false;
-    bool floating = m_conn.must_free_window(window);
-    bool fullscreen = m_conn.window_is_fullscreen(window);
-    bool sticky = m_conn.window_is_sticky(window);
+    bool floating = snapshot.must_free;
+    bool fullscreen = Util::contains(states, WindowState::Fullscreen);
+    bool sticky = Util::contains(states, WindowState::Sticky);
 
     Index partition = mp_partition->index();
     Index context = mp_context->index();
     Index workspace = mp_workspace->index();
 
-    std::optional<Index> desktop = m_conn.get_window_desktop(window);
+    std::optional<Index> desktop = snapshot.desktop;
 
     if (desktop) {
         context = *desktop / m_workspaces.size();
         workspace = *desktop % m_workspaces.size();
     }
 
-    std::optional<Hints> hints = m_conn.get_icccm_window_hints(window);
-    std::optional<SizeHints> size_hints
-        = m_conn.get_icccm_window_size_hints(window, std::nullopt);
+    std::optional<Hints> hints = snapshot.hints;
+    std::optional<SizeHints> size_hints = snapshot.size_hints;
 
     if (size_hints) {
         size_hints->apply(geometry.dim);
@@ -1751,8 +1968,8 @@ Model::manage(const Window window, const bool ignore, const bool may_map)
     Extents extents = Decoration::FREE_DECORATION.extents();
     geometry.apply_extents(extents);
 
-    std::optional<Window> parent = m_conn.get_icccm_window_transient_for(window);
-    std::optional<Window> leader = m_conn.get_icccm_window_client_leader(window);
+    std::optional<Window> parent = snapshot.transient_for;
+    std::optional<Window> leader = snapshot.client_leader;
 
     Client_ptr client = new Client(
         window,
@@ -1831,8 +2048,12 @@ Model::manage(const Window window, const bool ignore, const bool may_map)
         client->context = get_context(*rules.to_context);
 
     if (mp_attachment) {
-        client->workspace = mp_attachment.exchange(nullptr);
+        client->workspace = mp_attachment;
         client->attaching = true;
+
+        mp_attachment = nullptr;
+        m_timers.cancel(*m_attachment_timer);
+        m_attachment_timer = std::nullopt;
     } else if (rules.to_workspace && *rules.to_workspace < m_workspaces.size())
         client->workspace = get_workspace(*rules.to_workspace);
 
@@ -1876,8 +2097,15 @@ Model::manage(const Window window, const bool ignore, const bool may_map)
     m_client_map[window] = client;
     m_client_map[frame] = client;
 
+    m_client_list.push_back(window);
+    m_stacking_clients.push_back(client);
+
+    m_conn.update_client_list(m_client_list);
+    sync_client_list_stacking();
+
     m_conn.insert_window_in_save_set(window);
     m_conn.init_window(window);
+    client->sync_request = m_conn.init_sync_request(window);
     m_conn.init_frame(frame, client->workspace->focus_follows_mouse());
     m_conn.set_window_border_width(window, 0);
     m_conn.set_window_desktop(window, client->workspace->index());
@@ -1946,9 +2174,17 @@ Model::unmanage(Client_ptr client)
     Workspace_ptr workspace = client->workspace;
 
     m_conn.unparent_window(client->window, client->active_region.pos);
+    m_pending_offsets.erase(client->window);
+
+    auto sync_timeout = m_sync_timeouts.find(client);
+
+    if (sync_timeout != m_sync_timeouts.end()) {
+        m_timers.cancel(sync_timeout->second);
+        m_sync_timeouts.erase(sync_timeout);
+    }
 
     m_conn.cleanup_window(client->window);
-    m_conn.destroy_window(client->frame);
+    m_conn.release_frame(client->frame);
 
     workspace->remove_client(client);
     workspace->remove_icon(client);
@@ -1966,6 +2202,12 @@ Model::unmanage(Client_ptr client)
     m_client_map.erase(client->window);
     m_client_map.erase(client->frame);
 
+    Util::erase_remove(m_client_list, client->window);
+    Util::erase_remove(m_stacking_clients, client);
+
+    m_conn.update_client_list(m_client_list);
+    sync_client_list_stacking();
+
     m_fullscreen_map.erase(client);
 
     if (client->leader) {
@@ -2042,6 +2284,8 @@ Model::start_resizing(Client_ptr client)
 void
 Model::stop_moving()
 {
+    flush_motion();
+
     if (m_move_buffer.is_occupied()) {
         m_conn.release_pointer();
         m_move_buffer.unset();
@@ -2051,6 +2295,8 @@ Model::stop_moving()
 void
 Model::stop_resizing()
 {
+    flush_motion();
+
     if (m_resize_buffer.is_occupied()) {
         m_conn.release_pointer();
         m_resize_buffer.unset();
@@ -2177,6 +2423,61 @@ Model::perform_resize(Pos& pos)
     place_client(placement);
 }
 
+void
+Model::defer_motion(Pos pos)
+{
+    m_pending_motion = pos;
+
+    if (m_motion_timer)
+        return;
+
+    // the leading edge of a burst is applied immediately, anything after it
+    // is coalesced and applied at most once per refresh interval
+    flush_motion();
+
+    m_motion_timer = m_timers.schedule(
+        m_motion_interval,
+        [this]() {
+            m_motion_timer = std::nullopt;
+
+            if (m_pending_motion)
+                defer_motion(*m_pending_motion);
+        }
+    );
+}
+
+void
+Model::flush_motion()
+{
+    if (m_motion_timer) {
+        m_timers.cancel(*m_motion_timer);
+        m_motion_timer = std::nullopt;
+    }
+
+    if (!m_pending_motion)
+        return;
+
+    Pos pos = *m_pending_motion;
+    m_pending_motion = std::nullopt;
+
+    perform_move(pos);
+    perform_resize(pos);
+}
+
+void
+Model::update_motion_interval()
+{
+    static constexpr unsigned fallback_refresh_rate = 60;
+
+    unsigned refresh_rate = m_conn.get_refresh_rate();
+
+    if (!refresh_rate)
+        refresh_rate = fallback_refresh_rate;
+
+    m_motion_interval = std::chrono::microseconds(1000000 / refresh_rate);
+    spdlog::debug("applying interactive motion every {}us", m_motion_interval.count());
+}
+
 
 void
 Model::set_focus_follows_mouse(Toggle toggle, Index index)
@@ -2223,8 +2524,22 @@ Model::apply_layout(Workspace_ptr workspace)
     if (workspace != mp_workspace)
         return;
 
+    if (!m_dirty_layouts.insert(workspace).second)
+        ++m_coalesced_arrangements;
+}
+
+void
+Model::perform_layout(Workspace_ptr workspace)
+{
+    if (workspace != mp_workspace)
+        return;
+
+    // only placements that differ from what the client already has applied
+    // are submitted, so that e.g. a focus change in a tiled layout costs no
+    // configure requests
     for (Placement placement : workspace->arrange(active_screen().placeable_region()))
-        place_client(placement);
+        if (!is_placed(placement))
+            place_client(placement);
 }
 
 
@@ -2237,6 +2552,16 @@ Model::apply_stack(Index index)
 
 void
 Model::apply_stack(Workspace_ptr workspace)
+{
+    if (workspace != mp_workspace)
+        return;
+
+    if (!m_dirty_stacks.insert(workspace).second)
+        ++m_coalesced_arrangements;
+}
+
+void
+Model::perform_stack(Workspace_ptr workspace)
 {
     static std::vector<Window> stack;
 
@@ -2317,85 +2642,85 @@ Model::apply_stack(Workspace_ptr workspace)
     Util::append(stack, m_stack.get_layer(StackHandler::StackLayer::Above_));
     Util::append(stack, m_stack.get_layer(StackHandler::StackLayer::Notification));
 
-    bool order_changed = false;
-    std::optional<Window> prev_window
-        = stack.empty() ? std::nullopt : std::optional(stack[0]);
-
-    for (std::size_t i = 1; i < stack.size(); ++i) {
-        if (!order_changed) {
-            if (i < m_order.size())
-                order_changed |= m_order[i] != stack[i];
-            else
-                order_changed = true;
-        }
+    std::vector<StackHandler::Restack> const& restacks
+        = StackHandler::compute_restacks(m_order, stack);
 
-        if (order_changed)
-            m_conn.stack_window_above(stack[i], prev_window);
-
-        prev_window = stack[i];
-    }
-
-    if (!order_changed)
+    if (restacks.empty())
         return;
 
-    m_order = stack;
-
-    static constexpr struct ManagedSinceComparer final {
-        bool
-        operator()(const Client_ptr lhs, const Client_ptr rhs) const
-        {
-            return lhs->managed_since < rhs->managed_since;
+    for (StackHandler::Restack const& restack : restacks)
+        switch (restack.mode) {
+        case StackMode::Above_: m_conn.stack_window_above(restack.window, restack.sibling); break;
+        case StackMode::Below_: m_conn.stack_window_below(restack.window, restack.sibling); break;
         }
-    } managed_since_comparer{};
 
-    static std::set<Client_ptr, ManagedSinceComparer> managed_since_clients{{}, managed_since_comparer};
-    managed_since_clients.clear();
+    m_order = stack;
 
-    std::for_each(
-        m_client_map.begin(),
-        m_client_map.end(),
-        [](auto kv) {
-            managed_since_clients.insert(kv.second);
-        }
+    std::stable_sort(
+        m_stacking_clients.begin(),
+        m_stacking_clients.end(),
+        last_touched_comparer
     );
 
-    static std::vector<Window> order_list;
-    order_list.reserve(managed_since_clients.size());
-    order_list.clear();
+    sync_client_list_stacking();
+}
+
+void
+Model::sync_client_list_stacking()
+{
+    static std::vector<Window> stacking_list;
+    stacking_list.clear();
 
     std::transform(
-        managed_since_clients.begin(),
-        managed_since_clients.end(),
-        std::back_inserter(order_list),
+        m_stacking_clients.begin(),
+        m_stacking_clients.end(),
+        std::back_inserter(stacking_list),
         [](Client_ptr client) -> Window {
             return client->window;
         }
     );
 
-    m_conn.update_client_list(order_list);
+    m_conn.update_client_list_stacking(stacking_list);
+}
 
-    last_touched_clients.clear();
-    std::for_each(
-        m_client_map.begin(),
-        m_client_map.end(),
-        [](auto kv) {
-            last_touched_clients.insert(kv.second);
-        }
-    );
+void
+Model::flush_arrangements()
+{
+    static std::unordered_set<Workspace_ptr> workspaces;
 
-    order_list.reserve(last_touched_clients.size());
-    order_list.clear();
+    while (!m_dirty_layouts.empty() || !m_dirty_stacks.empty()) {
+        workspaces.clear();
+        std::swap(workspaces, m_dirty_layouts);
 
-    std::transform(
-        last_touched_clients.begin(),
-        last_touched_clients.end(),
-        std::back_inserter(order_list),
-        [](Client_ptr client) -> Window {
-            return client->window;
-        }
-    );
+        for (Workspace_ptr workspace : workspaces)
+            perform_layout(workspace);
+
+        workspaces.clear();
+        std::swap(workspaces, m_dirty_stacks);
+
+        for (Workspace_ptr workspace : workspaces)
+            perform_stack(workspace);
+    }
+
+    if (m_focus_deferred && mp_focus && mp_focus->mapped)
+        m_conn.focus_window(mp_focus->window);
+
+    m_focus_deferred = false;
+    flush_offsets();
+}
+
+void
+Model::flush_offsets()
+{
+    static std::vector<std::pair<Window, Region>> offsets;
+
+    if (m_pending_offsets.empty())
+        return;
+
+    offsets.assign(m_pending_offsets.begin(), m_pending_offsets.end());
+    m_pending_offsets.clear();
 
-    m_conn.update_client_list_stacking(order_list);
+    m_conn.update_window_offsets(offsets);
 }
 
 
@@ -3161,6 +3486,9 @@ Model::consume_client(Client_ptr producer, Client_ptr client)
     if (client->producer || !cworkspace->contains(client))
         return;
 
+    refresh_client_properties(producer);
+    refresh_client_properties(client);
+
     std::string producer_handle = producer->name
         + ":" + producer->class_
         + ":" + producer->instance;
@@ -3641,10 +3969,26 @@ Model::deiconify_all()
 
 
 void
-Model::spawn_external(std::string&& command) const
+Model::spawn_external(std::string&& command)
 {
     spdlog::info("calling external command: " + command);
-    m_conn.call_external_command(command);
+
+    if (std::optional<Pid> pid = m_spawner.spawn(command)) {
+        spdlog::debug("spawned process {}", *pid);
+        m_spawned_pids.insert(*pid);
+    } else
+        spdlog::warn("unable to spawn " + command);
+}
+
+void
+Model::prune_spawned_pids()
+{
+    // spawned processes are children of the helper, which has the kernel
+    // reap them, so no SIGCHLD reports their exit; a PID that no longer
+    // exists is dropped before it can be reused
+    std::erase_if(m_spawned_pids, [](Pid pid) {
+        return kill(static_cast<pid_t>(pid), 0) == -1 && errno == ESRCH;
+    });
 }
 
 
@@ -3654,6 +3998,8 @@ Model::exit()
     for (auto& [window,client] : m_client_map)
         m_conn.unparent_window(client->window, client->free_region.pos);
 
+    spdlog::debug("coalesced {} arrangements", m_coalesced_arrangements);
+
     m_conn.cleanup();
     m_running = false;
 
@@ -3673,8 +4019,8 @@ Model::handle_mouse(MouseEvent event)
     {
         resolve_active_partition(event.capture.root_rpos);
 
-        perform_move(event.capture.root_rpos);
-        perform_resize(event.capture.root_rpos);
+        if (m_move_buffer.is_occupied() || m_resize_buffer.is_occupied())
+            defer_motion(event.capture.root_rpos);
 
         return;
     }
@@ -3697,7 +4043,7 @@ Model::handle_mouse(MouseEvent event)
     ((*binding)(*this, client) && client && client != mp_focus)
     { // global binding
         input.target = MouseInput::MouseInputTarget::Global;
-        auto binding = Util::retrieve(m_mouse_bindings, input);
+        MouseAction const* binding = m_bindings.find(input);
 
         if (binding) {
             if (CALL_MUST_FOCUS(binding))
@@ -3709,7 +4055,7 @@ Model::handle_mouse(MouseEvent event)
 
     if (event.on_root) { // root binding
         input.target = MouseInput::MouseInputTarget::Root;
-        auto binding = Util::retrieve(m_mouse_bindings, input);
+        MouseAction const* binding = m_bindings.find(input);
 
         if (binding) {
             if (CALL_MUST_FOCUS(binding))
@@ -3721,7 +4067,7 @@ Model::handle_mouse(MouseEvent event)
 
     { // client binding
         input.target = MouseInput::MouseInputTarget::Client;
-        auto binding = Util::retrieve(m_mouse_bindings, input);
+        MouseAction const* binding = m_bindings.find(input);
 
         if (binding) {
             if (CALL_MUST_FOCUS(binding))
@@ -3739,20 +4085,35 @@ Model::handle_mouse(MouseEvent event)
 void
 Model::handle_key(KeyEvent event)
 {
-    auto binding = Util::retrieve(m_key_bindings, event.capture.input);
-
-    if (binding)
+    if (KeyAction const* binding = m_bindings.find(event.capture.input))
         (*binding)(*this);
 }
 
 void
 Model::handle_map_request(MapRequestEvent event)
 {
+    if (get_client(event.window))
+        return;
+
     bool must_restack = false;
     bool may_map = true;
 
-    std::optional<std::vector<std::optional<Strut>>> struts
-        = m_conn.get_window_strut(event.window);
+    WindowSnapshot snapshot{};
+
+    // windows that will not be managed only need what decides their struts
+    // and stack layer, the full snapshot is fetched for those that will be
+    if (event.ignore) {
+        snapshot.window = event.window;
+        snapshot.geometry = m_conn.get_window_geometry(event.window);
+        snapshot.mappable = m_conn.window_is_mappable(event.window);
+        snapshot.types = m_conn.get_window_types(event.window);
+        snapshot.states = m_conn.get_window_states(event.window);
+        snapshot.struts = m_conn.get_window_strut(event.window);
+    } else
+        snapshot = m_conn.fetch_window_snapshot(event.window);
+
+    std::optional<std::vector<std::optional<Strut>>> const& struts
+        = snapshot.struts;
 
     if (struts) {
         Screen& screen = active_screen();
@@ -3761,7 +4122,7 @@ Model::handle_map_request(MapRequestEvent event)
         if (screen.showing_struts()) {
             screen.compute_placeable_region();
 
-            if (m_conn.window_is_mappable(event.window))
+            if (snapshot.mappable)
                 m_conn.map_window(event.window);
 
             apply_layout(mp_workspace);
@@ -3770,14 +4131,9 @@ Model::handle_map_request(MapRequestEvent event)
             may_map = false;
     }
 
-    std::unordered_set<WindowType> types
-        = m_conn.get_window_types(event.window);
-
-    std::unordered_set<WindowState> states
-        = m_conn.get_window_states(event.window);
-
-    std::optional<Region> region
-        = m_conn.get_window_geometry(event.window);
+    EnumSet<WindowType> const& types = snapshot.types;
+    EnumSet<WindowState> const& states = snapshot.states;
+    std::optional<Region> region = snapshot.geometry;
 
     std::optional<StackHandler::StackLayer> layer = std::nullopt;
 
@@ -3849,8 +4205,7 @@ Model::handle_map_request(MapRequestEvent event)
     if (!may_map)
         m_conn.unmap_window(event.window);
 
-    if (!(m_client_map.count(event.window) > 0))
-        manage(event.window, event.ignore, may_map);
+    manage(snapshot, event.ignore, may_map);
 }
 
 void
@@ -4136,7 +4491,7 @@ Model::handle_property(PropertyEvent event)
         if (!client)
             return;
 
-        client->name = m_conn.get_icccm_window_name(event.window);
+        client->name_dirty = true;
 
         return;
     }
@@ -4147,8 +4502,7 @@ Model::handle_property(PropertyEvent event)
         if (!client)
             return;
 
-        client->class_ = m_conn.get_icccm_window_class(event.window);
-        client->instance = m_conn.get_icccm_window_instance(event.window);
+        client->class_dirty = true;
 
         return;
     }
@@ -4254,7 +4608,29 @@ Model::handle_frame_extents_request(FrameExtentsRequestEvent event)
 
 void
 Model::handle_screen_change()
-{}
+{
+    update_motion_interval();
+}
+
+void
+Model::handle_sync(SyncEvent event)
+{
+    Client_ptr client = get_client(event.window);
+
+    if (!client)
+        return;
+
+    auto timeout = m_sync_timeouts.find(client);
+
+    if (timeout == m_sync_timeouts.end())
+        return;
+
+    m_timers.cancel(timeout->second);
+    m_sync_timeouts.erase(timeout);
+
+    if (client->sync_held)
+        commit_placement(client);
+}
 
 
 void
@@ -4374,25 +4750,3 @@ Model::process_query(winsys::QueryMessage)
 {
     // TODO
 }
-
-
-// static methods
-
-void
-Model::wait_children(int)
-{
-    struct sigaction child_sa;
-
-    std::memset(&child_sa, 0, sizeof(child_sa));
-    child_sa.sa_handler = &Model::wait_children;
-
-    sigaction(SIGCHLD, &child_sa,  NULL);
-    while (waitpid(-1, 0, WNOHANG) > 0);
-}
-
-void
-Model::handle_signal(int sig)
-{
-    if (sig == SIGHUP || sig == SIGINT || sig == SIGTERM)
-        g_instance->exit();
-}
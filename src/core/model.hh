@@ -11,14 +11,19 @@
 #include "layout.hh"
 #include "partition.hh"
 #include "partition.hh"
+#include "processes.hh"
 #include "rules.hh"
 #include "search.hh"
+#include "spawner.hh"
 #include "stack.hh"
+#include "timers.hh"
 #include "workspace.hh"
 
-#include <atomic>
 #include <cstddef>
+#include <functional>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class Model;
@@ -30,11 +35,13 @@ public:
 
     void run();
 
-private:
-    static void wait_children(int);
-    static void handle_signal(int);
+    // a single iteration of the event loop, for drivers that script the
+    // connection instead of waiting on a display
+    void step();
 
-    void init_signals() const;
+private:
+    void init_signals();
+    void handle_signals();
 
     void handle_mouse(winsys::MouseEvent);
     void handle_key(winsys::KeyEvent);
@@ -56,6 +63,7 @@ private:
     void handle_property(winsys::PropertyEvent);
     void handle_frame_extents_request(winsys::FrameExtentsRequestEvent);
     void handle_screen_change();
+    void handle_sync(winsys::SyncEvent);
 
     void process_command(winsys::CommandMessage);
     void process_config(winsys::ConfigMessage);
@@ -74,6 +82,7 @@ private:
 
     Client_ptr search_client(SearchSelector const&);
     bool client_matches_search(Client_ptr, SearchSelector const&) const;
+    void refresh_client_properties(Client_ptr) const;
 
     Partition_ptr active_partition() const;
     Partition_ptr get_partition(Index) const;
@@ -86,7 +95,9 @@ private:
 
     bool is_free(Client_ptr) const;
 
+    bool is_placed(Placement const&) const;
     void place_client(Placement&);
+    void commit_placement(Client_ptr);
 
     void map_client(Client_ptr);
     void unmap_client(Client_ptr);
@@ -119,7 +130,8 @@ private:
 
     Rules retrieve_rules(Client_ptr) const;
 
-    void manage(const winsys::Window, const bool, const bool);
+    void adopt_windows();
+    void manage(winsys::WindowSnapshot const&, const bool, const bool);
     void unmanage(Client_ptr);
 
     void start_moving(Client_ptr);
@@ -131,6 +143,10 @@ private:
     void perform_move(winsys::Pos&);
     void perform_resize(winsys::Pos&);
 
+    void defer_motion(winsys::Pos);
+    void flush_motion();
+    void update_motion_interval();
+
     void set_focus_follows_mouse(winsys::Toggle, Index);
     void set_focus_follows_mouse(winsys::Toggle, Workspace_ptr);
 
@@ -140,6 +156,12 @@ private:
     void apply_stack(Index);
     void apply_stack(Workspace_ptr);
 
+    void perform_layout(Workspace_ptr);
+    void perform_stack(Workspace_ptr);
+    void sync_client_list_stacking();
+    void flush_arrangements();
+    void flush_offsets();
+
     void cycle_focus(winsys::Direction);
     void drag_focus(winsys::Direction);
 
@@ -214,12 +236,17 @@ private:
     void pop_deiconify();
     void deiconify_all();
 
-    void spawn_external(std::string&&) const;
+    void spawn_external(std::string&&);
+    void prune_spawned_pids();
 
     void exit();
 
     winsys::Connection& m_conn;
 
+    // forked before the rest of the model is built
+    Spawner m_spawner;
+    ProcessTree m_processes;
+
     bool m_running;
 
     Cycle<Partition_ptr> m_partitions;
@@ -234,16 +261,24 @@ private:
     Context_ptr mp_prev_context;
     Workspace_ptr mp_prev_workspace;
 
-    std::atomic<Workspace_ptr> mp_attachment;
+    Workspace_ptr mp_attachment;
+    std::optional<TimerHandler::TimerId> m_attachment_timer;
 
     Buffer m_move_buffer;
     Buffer m_resize_buffer;
 
+    std::optional<winsys::Pos> m_pending_motion;
+    std::optional<TimerHandler::TimerId> m_motion_timer;
+    std::chrono::microseconds m_motion_interval;
+
     StackHandler m_stack;
     std::vector<winsys::Window> m_order;
+    std::vector<winsys::Window> m_client_list;
+    std::vector<Client_ptr> m_stacking_clients;
 
     std::unordered_map<winsys::Window, Client_ptr> m_client_map;
     std::unordered_map<winsys::Pid, Client_ptr> m_pid_map;
+    std::unordered_set<winsys::Pid> m_spawned_pids;
     std::unordered_map<Client_ptr, winsys::Region> m_fullscreen_map;
     std::unordered_map<winsys::Window, std::vector<Client_ptr>> m_leader_map;
 
@@ -253,8 +288,19 @@ private:
     Client_ptr mp_focus;
     Client_ptr mp_jumped_from;
 
+    std::unordered_set<Workspace_ptr> m_dirty_layouts;
+    std::unordered_set<Workspace_ptr> m_dirty_stacks;
+    std::size_t m_coalesced_arrangements;
+    bool m_focus_deferred;
+    std::unordered_map<winsys::Window, winsys::Region> m_pending_offsets;
+    std::unordered_map<Client_ptr, TimerHandler::TimerId> m_sync_timeouts;
+
+    int m_signal_fd;
+    TimerHandler m_timers;
+
     KeyBindings m_key_bindings;
     MouseBindings m_mouse_bindings;
+    BindingTable m_bindings;
 
     struct EventVisitor final
     {
@@ -342,6 +388,10 @@ private:
             m_model.handle_screen_change();
         }
 
+        void operator()(winsys::SyncEvent event) {
+            m_model.handle_sync(event);
+        }
+
     private:
         Model& m_model;
 
@@ -378,6 +428,17 @@ private:
 
     } m_message_visitor = MessageVisitor(*this);
 
+    // the callbacks capture nothing but the model, and are built only once
+    const std::function<void(winsys::Event)> m_process_event
+        = [this](winsys::Event event) {
+            std::visit(m_event_visitor, event);
+        };
+
+    const std::function<void(winsys::Message)> m_process_message
+        = [this](winsys::Message message) {
+            std::visit(m_message_visitor, message);
+        };
+
     Config m_config;
 
 };
@@ -0,0 +1,233 @@
+#include "../winsys/util.hh"
+#include "processes.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+ProcessTree::ProcessTree()
+    : m_fd(-1),
+      m_parents({}),
+      m_children({})
+{
+    if (!listen() && m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+ProcessTree::~ProcessTree()
+{
+    if (m_fd != -1)
+        close(m_fd);
+}
+
+
+int
+ProcessTree::fd() const
+{
+    return m_fd;
+}
+
+std::optional<winsys::Pid>
+ProcessTree::parent(winsys::Pid pid)
+{
+    if (m_fd == -1)
+        return read_parent(pid);
+
+    auto cached = m_parents.find(pid);
+
+    if (cached != m_parents.end())
+        return cached->second;
+
+    std::optional<winsys::Pid> ppid = read_parent(pid);
+
+    if (ppid) {
+        m_parents[pid] = *ppid;
+        m_children[*ppid].push_back(pid);
+    }
+
+    return ppid;
+}
+
+void
+ProcessTree::process_events()
+{
+    if (m_fd == -1)
+        return;
+
+    bool complete = drain([this](struct proc_event const& event) {
+        if (event.what == proc_event::PROC_EVENT_EXIT
+            && event.event_data.exit.process_pid == event.event_data.exit.process_tgid)
+        {
+            forget(event.event_data.exit.process_tgid);
+        }
+    });
+
+    // events were dropped, so nothing cached can be trusted anymore
+    if (!complete)
+        forget_all();
+}
+
+
+bool
+ProcessTree::listen()
+{
+    m_fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+
+    if (m_fd == -1)
+        return false;
+
+    struct sockaddr_nl address;
+    std::memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+
+    if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == -1)
+        return false;
+
+    static constexpr std::size_t payload_size
+        = sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op);
+
+    alignas(struct nlmsghdr) char request[NLMSG_SPACE(payload_size)];
+    std::memset(request, 0, sizeof(request));
+
+    struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(request);
+    header->nlmsg_len = NLMSG_LENGTH(payload_size);
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = getpid();
+
+    struct cn_msg* message = reinterpret_cast<struct cn_msg*>(request + NLMSG_HDRLEN);
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(enum proc_cn_mcast_op);
+
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(message->data, &op, sizeof(op));
+
+    if (send(m_fd, request, header->nlmsg_len, 0) == -1)
+        return false;
+
+    // the kernel acknowledges the subscription before send returns; events
+    // queued ahead of the acknowledgement predate the cache and are dropped
+    std::optional<int> error = std::nullopt;
+
+    drain([&error](struct proc_event const& event) {
+        if (event.what == proc_event::PROC_EVENT_NONE && !error)
+            error = event.event_data.ack.err;
+    });
+
+    return error && *error == 0;
+}
+
+bool
+ProcessTree::drain(std::function<void(struct proc_event const&)> const& handler)
+{
+    alignas(struct nlmsghdr) static char buffer[4096];
+    ssize_t length;
+
+    while ((length = recv(m_fd, buffer, sizeof(buffer), 0)) > 0) {
+        struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(buffer);
+
+        for (; NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_OVERRUN)
+                return false;
+
+            struct cn_msg* message = reinterpret_cast<struct cn_msg*>(
+                reinterpret_cast<char*>(header) + NLMSG_HDRLEN
+            );
+
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC
+                || message->len < sizeof(struct proc_event))
+            {
+                continue;
+            }
+
+            // the payload follows the 20-byte connector header unaligned
+            struct proc_event event;
+            std::memcpy(&event, message->data, sizeof(event));
+
+            handler(event);
+        }
+    }
+
+    return length == 0 || errno != ENOBUFS;
+}
+
+void
+ProcessTree::forget(winsys::Pid pid)
+{
+    auto parent = m_parents.find(pid);
+
+    if (parent != m_parents.end()) {
+        auto siblings = m_children.find(parent->second);
+
+        if (siblings != m_children.end()) {
+            Util::erase_remove(siblings->second, pid);
+
+            if (siblings->second.empty())
+                m_children.erase(siblings);
+        }
+
+        m_parents.erase(parent);
+    }
+
+    // orphans are adopted by another process, so their cached parent is void
+    auto children = m_children.find(pid);
+
+    if (children != m_children.end()) {
+        for (winsys::Pid child : children->second)
+            m_parents.erase(child);
+
+        m_children.erase(children);
+    }
+}
+
+void
+ProcessTree::forget_all()
+{
+    m_parents.clear();
+    m_children.clear();
+}
+
+std::optional<winsys::Pid>
+ProcessTree::read_parent(winsys::Pid pid)
+{
+    static char path[32];
+    static char stat[512];
+
+    std::snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+        return std::nullopt;
+
+    ssize_t length = read(fd, stat, sizeof(stat) - 1);
+    close(fd);
+
+    if (length <= 0)
+        return std::nullopt;
+
+    stat[length] = '\0';
+
+    // the command name is enclosed in parentheses, and may contain them
+    char* name_end = std::strrchr(stat, ')');
+
+    char state;
+    int ppid;
+
+    if (!name_end || std::sscanf(name_end + 1, " %c %d", &state, &ppid) != 2 || ppid <= 0)
+        return std::nullopt;
+
+    return static_cast<winsys::Pid>(ppid);
+}
@@ -0,0 +1,45 @@
+#ifndef __PROCESSES_H_GUARD__
+#define __PROCESSES_H_GUARD__
+
+#include "../winsys/common.hh"
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// An index from process to parent process, used to find the client that
+// produced a new window. Parents are read from /proc/<pid>/stat on first use
+// and cached for as long as the kernel's process connector reports nothing
+// that would invalidate them; without the connector, which requires
+// CAP_NET_ADMIN, nothing is cached and every lookup reads /proc.
+class ProcessTree final
+{
+public:
+    ProcessTree();
+    ~ProcessTree();
+
+    ProcessTree(const ProcessTree&) = delete;
+    ProcessTree& operator=(const ProcessTree&) = delete;
+
+    int fd() const;
+
+    std::optional<winsys::Pid> parent(winsys::Pid);
+    void process_events();
+
+private:
+    int m_fd;
+
+    std::unordered_map<winsys::Pid, winsys::Pid> m_parents;
+    std::unordered_map<winsys::Pid, std::vector<winsys::Pid>> m_children;
+
+    bool listen();
+    bool drain(std::function<void(struct proc_event const&)> const&);
+    void forget(winsys::Pid);
+    void forget_all();
+
+    static std::optional<winsys::Pid> read_parent(winsys::Pid);
+
+};
+
+#endif//__PROCESSES_H_GUARD__
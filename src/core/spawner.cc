@@ -0,0 +1,175 @@
+#include "../winsys/util.hh"
+#include "spawner.hh"
+
+#include <cstdint>
+
+extern "C" {
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+extern char** environ;
+
+Spawner::Spawner()
+    : m_fd(-1),
+      m_pid(0)
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1)
+        Util::die("unable to set up spawner channel");
+
+    pid_t pid = fork();
+
+    if (pid == -1)
+        Util::die("unable to fork spawner");
+
+    if (pid == 0) {
+        // the helper holds on to nothing of the window manager but its end of
+        // the channel
+        for (int fd = 3; fd < sysconf(_SC_OPEN_MAX) && fd < 1024; ++fd)
+            if (fd != fds[1])
+                close(fd);
+
+        serve(fds[1]);
+    }
+
+    close(fds[1]);
+
+    m_fd = fds[0];
+    m_pid = pid;
+}
+
+Spawner::~Spawner()
+{
+    // the helper exits once its end of the channel reaches end-of-file
+    close(m_fd);
+    waitpid(m_pid, NULL, 0);
+}
+
+
+std::optional<winsys::Pid>
+Spawner::spawn(std::string const& command) const
+{
+    std::uint32_t length = command.size();
+    pid_t pid;
+
+    if (!write_all(m_fd, &length, sizeof(length))
+        || !write_all(m_fd, command.data(), length)
+        || !read_all(m_fd, &pid, sizeof(pid)))
+    {
+        Util::warn("spawner is unresponsive");
+        return std::nullopt;
+    }
+
+    if (pid <= 0)
+        return std::nullopt;
+
+    return pid;
+}
+
+winsys::Pid
+Spawner::pid() const
+{
+    return m_pid;
+}
+
+
+void
+Spawner::serve(int fd)
+{
+    // spawned processes are reaped by the kernel, and start out with the
+    // default dispositions and an empty signal mask
+    signal(SIGCHLD, SIG_IGN);
+
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGCHLD);
+    sigaddset(&default_signals, SIGPIPE);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    posix_spawnattr_setsigmask(&attr, &mask);
+
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_SETSID
+    flags |= POSIX_SPAWN_SETSID;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    std::string command;
+
+    for (;;) {
+        std::uint32_t length;
+
+        if (!read_all(fd, &length, sizeof(length)))
+            break;
+
+        command.resize(length);
+
+        if (!read_all(fd, command.data(), length))
+            break;
+
+        command.insert(0, "exec ");
+
+        char* argv[] = {
+            const_cast<char*>("/bin/sh"),
+            const_cast<char*>("-c"),
+            command.data(),
+            NULL
+        };
+
+        pid_t pid;
+        if (posix_spawn(&pid, "/bin/sh", NULL, &attr, argv, environ) != 0)
+            pid = -1;
+
+        if (!write_all(fd, &pid, sizeof(pid)))
+            break;
+    }
+
+    posix_spawnattr_destroy(&attr);
+    _exit(EXIT_SUCCESS);
+}
+
+bool
+Spawner::read_all(int fd, void* data, std::size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+
+        if (n <= 0)
+            return false;
+
+        bytes += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+bool
+Spawner::write_all(int fd, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+
+        if (n <= 0)
+            return false;
+
+        bytes += n;
+        size -= n;
+    }
+
+    return true;
+}
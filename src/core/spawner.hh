@@ -0,0 +1,36 @@
+#ifndef __SPAWNER_H_GUARD__
+#define __SPAWNER_H_GUARD__
+
+#include "../winsys/common.hh"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+// A helper process, forked once while the window manager is still small,
+// that launches commands on its behalf with posix_spawn and reports back the
+// PID of every process it started.
+class Spawner final
+{
+public:
+    Spawner();
+    ~Spawner();
+
+    Spawner(const Spawner&) = delete;
+    Spawner& operator=(const Spawner&) = delete;
+
+    std::optional<winsys::Pid> spawn(std::string const&) const;
+    winsys::Pid pid() const;
+
+private:
+    int m_fd;
+    winsys::Pid m_pid;
+
+    [[noreturn]] static void serve(int);
+
+    static bool read_all(int, void*, std::size_t);
+    static bool write_all(int, const void*, std::size_t);
+
+};
+
+#endif//__SPAWNER_H_GUARD__
@@ -1,6 +1,9 @@
 #include "stack.hh"
 #include "../winsys/util.hh"
 
+#include <algorithm>
+#include <optional>
+
 StackHandler::StackHandler()
     : m_layers({}),
       m_desktop({}),
@@ -118,3 +121,93 @@ StackHandler::get_layer(StackLayer layer) const
 
     return get_layer(StackLayer::Desktop);
 }
+
+
+// Determines the moves that turn the (bottom-to-top) stacking order prev into
+// next. Windows along a longest increasing subsequence of their positions in
+// prev are already in the right relative order and stay put; every other
+// window is stacked directly above its predecessor in next.
+std::vector<StackHandler::Restack> const&
+StackHandler::compute_restacks(
+    std::vector<winsys::Window> const& prev,
+    std::vector<winsys::Window> const& next
+)
+{
+    static std::vector<Restack> restacks;
+    static std::unordered_map<winsys::Window, std::size_t> prev_indices;
+    static std::vector<std::optional<std::size_t>> predecessors;
+    static std::vector<std::size_t> tails;
+    static std::vector<std::size_t> indices;
+    static std::vector<bool> kept;
+
+    restacks.clear();
+
+    if (next.empty())
+        return restacks;
+
+    prev_indices.clear();
+    for (std::size_t i = 0; i < prev.size(); ++i)
+        prev_indices[prev[i]] = i;
+
+    indices.assign(next.size(), prev.size());
+    predecessors.assign(next.size(), std::nullopt);
+    kept.assign(next.size(), false);
+    tails.clear();
+
+    for (std::size_t i = 0; i < next.size(); ++i) {
+        std::unordered_map<winsys::Window, std::size_t>::iterator iter
+            = prev_indices.find(next[i]);
+
+        if (iter == prev_indices.end())
+            continue;
+
+        indices[i] = iter->second;
+
+        std::vector<std::size_t>::iterator tail = std::lower_bound(
+            tails.begin(),
+            tails.end(),
+            indices[i],
+            [](std::size_t tail, std::size_t index) -> bool {
+                return indices[tail] < index;
+            }
+        );
+
+        if (tail != tails.begin())
+            predecessors[i] = *(tail - 1);
+
+        if (tail == tails.end())
+            tails.push_back(i);
+        else
+            *tail = i;
+    }
+
+    if (tails.empty())
+        kept[0] = true;
+    else
+        for (std::optional<std::size_t> i = tails.back(); i; i = predecessors[*i])
+            kept[*i] = true;
+
+    std::size_t lowest_kept = static_cast<std::size_t>(
+        std::distance(kept.begin(), std::find(kept.begin(), kept.end(), true))
+    );
+
+    for (std::size_t i = 0; i < next.size(); ++i) {
+        if (kept[i])
+            continue;
+
+        if (i == 0)
+            restacks.push_back(Restack {
+                next[0],
+                next[lowest_kept],
+                winsys::StackMode::Below_
+            });
+        else
+            restacks.push_back(Restack {
+                next[i],
+                next[i - 1],
+                winsys::StackMode::Above_
+            });
+    }
+
+    return restacks;
+}
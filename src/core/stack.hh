@@ -1,6 +1,7 @@
 #ifndef __STACK_H_GUARD__
 #define __STACK_H_GUARD__
 
+#include "../winsys/event.hh"
 #include "../winsys/window.hh"
 
 #include <unordered_map>
@@ -22,6 +23,13 @@ public:
         Notification,
     };
 
+    struct Restack final
+    {
+        winsys::Window window;
+        winsys::Window sibling;
+        winsys::StackMode mode;
+    };
+
     StackHandler();
     ~StackHandler();
 
@@ -36,6 +44,11 @@ public:
 
     std::vector<winsys::Window> const& get_layer(StackLayer) const;
 
+    static std::vector<Restack> const& compute_restacks(
+        std::vector<winsys::Window> const&,
+        std::vector<winsys::Window> const&
+    );
+
 private:
     std::unordered_map<winsys::Window, StackLayer> m_layers;
 
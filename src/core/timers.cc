@@ -0,0 +1,107 @@
+#include "../winsys/util.hh"
+#include "timers.hh"
+
+#include <cstdint>
+
+extern "C" {
+#include <sys/timerfd.h>
+#include <unistd.h>
+}
+
+TimerHandler::TimerHandler()
+    : m_fd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+      m_next_id(0),
+      m_timers({}),
+      m_deadlines({})
+{
+    if (m_fd == -1)
+        Util::die("unable to create timer");
+}
+
+TimerHandler::~TimerHandler()
+{
+    close(m_fd);
+}
+
+
+int
+TimerHandler::fd() const
+{
+    return m_fd;
+}
+
+TimerHandler::TimerId
+TimerHandler::schedule(std::chrono::microseconds delay, std::function<void()> action)
+{
+    TimerId id = m_next_id++;
+    Deadline deadline = std::chrono::steady_clock::now() + delay;
+
+    m_timers[{ deadline, id }] = action;
+    m_deadlines[id] = deadline;
+
+    if (m_timers.begin()->first.second == id)
+        arm();
+
+    return id;
+}
+
+void
+TimerHandler::cancel(TimerId id)
+{
+    auto deadline = m_deadlines.find(id);
+
+    if (deadline == m_deadlines.end())
+        return;
+
+    bool earliest = m_timers.begin()->first.second == id;
+
+    m_timers.erase({ deadline->second, id });
+    m_deadlines.erase(deadline);
+
+    if (earliest)
+        arm();
+}
+
+void
+TimerHandler::expire()
+{
+    std::uint64_t expirations;
+    while (read(m_fd, &expirations, sizeof(expirations)) > 0);
+
+    Deadline now = std::chrono::steady_clock::now();
+
+    // actions may schedule or cancel timers themselves, so every expired
+    // timer is unlinked before its action runs
+    while (!m_timers.empty() && m_timers.begin()->first.first <= now) {
+        auto timer = m_timers.begin();
+        std::function<void()> action = std::move(timer->second);
+
+        m_deadlines.erase(timer->first.second);
+        m_timers.erase(timer);
+
+        action();
+    }
+
+    arm();
+}
+
+void
+TimerHandler::arm()
+{
+    struct itimerspec spec = {};
+
+    if (!m_timers.empty()) {
+        auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            m_timers.begin()->first.first - std::chrono::steady_clock::now()
+        );
+
+        // a zero value would disarm the timer
+        if (delay.count() <= 0)
+            delay = std::chrono::nanoseconds(1);
+
+        spec.it_value.tv_sec = delay.count() / 1000000000;
+        spec.it_value.tv_nsec = delay.count() % 1000000000;
+    }
+
+    timerfd_settime(m_fd, 0, &spec, NULL);
+}
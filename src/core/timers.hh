@@ -0,0 +1,42 @@
+#ifndef __TIMERS_H_GUARD__
+#define __TIMERS_H_GUARD__
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+// Deferred actions, all driven by a single timerfd that is armed for the
+// earliest pending deadline and watched by the event loop.
+class TimerHandler final
+{
+public:
+    typedef std::size_t TimerId;
+    typedef std::chrono::steady_clock::time_point Deadline;
+
+    TimerHandler();
+    ~TimerHandler();
+
+    TimerHandler(const TimerHandler&) = delete;
+    TimerHandler& operator=(const TimerHandler&) = delete;
+
+    int fd() const;
+
+    TimerId schedule(std::chrono::microseconds, std::function<void()>);
+    void cancel(TimerId);
+    void expire();
+
+private:
+    int m_fd;
+    TimerId m_next_id;
+
+    std::map<std::pair<Deadline, TimerId>, std::function<void()>> m_timers;
+    std::unordered_map<TimerId, Deadline> m_deadlines;
+
+    void arm();
+
+};
+
+#endif//__TIMERS_H_GUARD__
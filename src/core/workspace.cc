@@ -564,31 +564,102 @@ Workspace::set_layout(LayoutHandler::LayoutKind layout)
     m_layout_handler.set_kind(layout);
 }
 
-std::vector<Placement>
+void
+Workspace::gather_arrangement_inputs(ArrangementInputs& inputs, winsys::Region region) const
+{
+    inputs.region = region;
+    inputs.kind = m_layout_handler.kind();
+    inputs.margin = m_layout_handler.margin();
+    inputs.gap_size = m_layout_handler.gap_size();
+    inputs.main_count = m_layout_handler.main_count();
+    inputs.main_factor = m_layout_handler.main_factor();
+
+    inputs.clients.clear();
+    inputs.clients.reserve(m_clients.size());
+
+    std::transform(
+        m_clients.begin(),
+        m_clients.end(),
+        std::back_inserter(inputs.clients),
+        [](const Client_ptr client) -> ArrangementInputs::ClientInputs {
+            return ArrangementInputs::ClientInputs {
+                client,
+                client->fullscreen,
+                client->contained,
+                Client::is_free(client),
+                client->focused,
+                client->free_region,
+                client->last_focused
+            };
+        }
+    );
+}
+
+std::vector<Placement> const&
 Workspace::arrange(winsys::Region region) const
 {
-    std::deque<Client_ptr> clients = m_clients.as_deque();
-    std::vector<Placement> placements;
-    placements.reserve(clients.size());
+    gather_arrangement_inputs(m_next_arrangement_inputs, region);
+
+    if (m_arrangement_inputs == m_next_arrangement_inputs)
+        return m_placements;
 
-    auto fullscreen_iter = std::stable_partition(
-        clients.begin(),
-        clients.end(),
-        [](const Client_ptr client) -> bool {
-            return client->fullscreen && !client->contained;
+    if (m_arrangement_inputs)
+        std::swap(*m_arrangement_inputs, m_next_arrangement_inputs);
+    else
+        m_arrangement_inputs = m_next_arrangement_inputs;
+
+    // the clients are ordered fullscreen first, free second and tiled last,
+    // into buffers that are reused across arrangements
+    std::vector<Client_ptr>& clients = m_arranged_clients;
+    clients.clear();
+    clients.reserve(m_clients.size());
+
+    std::vector<Placement>& placements = m_placements;
+    placements.clear();
+    placements.reserve(m_clients.size());
+
+    auto is_fullscreen = [](const Client_ptr client) -> bool {
+        return client->fullscreen && !client->contained;
+    };
+
+    auto is_free = [=,this](const Client_ptr client) -> bool {
+        return !layout_is_free() && Client::is_free(client);
+    };
+
+    std::copy_if(
+        m_clients.begin(),
+        m_clients.end(),
+        std::back_inserter(clients),
+        is_fullscreen
+    );
+
+    std::size_t n_fullscreen = clients.size();
+
+    std::copy_if(
+        m_clients.begin(),
+        m_clients.end(),
+        std::back_inserter(clients),
+        [=](const Client_ptr client) -> bool {
+            return !is_fullscreen(client) && is_free(client);
         }
     );
 
-    auto free_iter = std::stable_partition(
-        fullscreen_iter,
-        clients.end(),
-        [=,this](const Client_ptr client) -> bool {
-            return !layout_is_free() && Client::is_free(client);
+    std::size_t n_free = clients.size() - n_fullscreen;
+
+    std::copy_if(
+        m_clients.begin(),
+        m_clients.end(),
+        std::back_inserter(clients),
+        [=](const Client_ptr client) -> bool {
+            return !is_fullscreen(client) && !is_free(client);
         }
     );
 
+    auto fullscreen_iter = clients.cbegin() + n_fullscreen;
+    auto free_iter = fullscreen_iter + n_free;
+
     std::transform(
-        clients.begin(),
+        clients.cbegin(),
         fullscreen_iter,
         std::back_inserter(placements),
         [region](const Client_ptr client) -> Placement {
@@ -619,7 +690,7 @@ Workspace::arrange(winsys::Region region) const
         region,
         placements,
         free_iter,
-        clients.end()
+        clients.cend()
     );
 
     if (layout_is_single()) {
@@ -633,5 +704,5 @@ Workspace::arrange(winsys::Region region) const
         );
     }
 
-    return placements;
+    return m_placements;
 }
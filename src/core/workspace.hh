@@ -11,6 +11,7 @@
 #include "layout.hh"
 #include "placement.hh"
 
+#include <chrono>
 #include <cstdlib>
 #include <deque>
 #include <string>
@@ -135,7 +136,11 @@ public:
           m_clients({}, true),
           m_icons({}, true),
           m_disowned({}, true),
-          m_focus_follows_mouse(false)
+          m_focus_follows_mouse(false),
+          m_arrangement_inputs(std::nullopt),
+          m_next_arrangement_inputs({}),
+          m_arranged_clients({}),
+          m_placements({})
     {}
 
     bool empty() const;
@@ -212,7 +217,7 @@ public:
 
     void toggle_layout();
     void set_layout(LayoutHandler::LayoutKind);
-    std::vector<Placement> arrange(winsys::Region) const;
+    std::vector<Placement> const& arrange(winsys::Region) const;
 
     std::deque<Client_ptr>::iterator
     begin()
@@ -277,6 +282,41 @@ private:
 
     bool m_focus_follows_mouse;
 
+    // everything an arrangement depends on; as long as these do not change,
+    // the previously computed placements are reused
+    struct ArrangementInputs final
+    {
+        struct ClientInputs final
+        {
+            Client_ptr client;
+            bool fullscreen;
+            bool contained;
+            bool free;
+            bool focused;
+            winsys::Region free_region;
+            std::chrono::time_point<std::chrono::steady_clock> last_focused;
+
+            bool operator==(ClientInputs const&) const = default;
+        };
+
+        winsys::Region region;
+        LayoutHandler::LayoutKind kind;
+        winsys::Extents margin;
+        std::size_t gap_size;
+        std::size_t main_count;
+        float main_factor;
+        std::vector<ClientInputs> clients;
+
+        bool operator==(ArrangementInputs const&) const = default;
+    };
+
+    mutable std::optional<ArrangementInputs> m_arrangement_inputs;
+    mutable ArrangementInputs m_next_arrangement_inputs;
+    mutable std::vector<Client_ptr> m_arranged_clients;
+    mutable std::vector<Placement> m_placements;
+
+    void gather_arrangement_inputs(ArrangementInputs&, winsys::Region) const;
+
 }* Workspace_ptr;
 
 #endif//__WORKSPACE_H_GUARD__
@@ -0,0 +1,66 @@
+#include "allocations.hh"
+
+#include <cstdlib>
+#include <new>
+
+static std::size_t s_allocations = 0;
+
+std::size_t
+allocation_count()
+{
+    return s_allocations;
+}
+
+void*
+operator new(std::size_t size)
+{
+    ++s_allocations;
+
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void
+operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void*
+operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    ++s_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void*
+operator new[](std::size_t size, std::nothrow_t const& nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void
+operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void
+operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,10 @@
+#ifndef __TEST_ALLOCATIONS_H_GUARD__
+#define __TEST_ALLOCATIONS_H_GUARD__
+
+#include <cstddef>
+
+// The global allocation functions are replaced in every binary this is linked
+// into, so that heap allocations can be counted around the code under test.
+std::size_t allocation_count();
+
+#endif//__TEST_ALLOCATIONS_H_GUARD__
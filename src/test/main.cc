@@ -0,0 +1,264 @@
+#include "../core/model.hh"
+#include "../winsys/mock/mockconnection.hh"
+#include "allocations.hh"
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+// Per-operation budgets, checked by scripting the model over an in-memory
+// connection. Every budget is an upper bound; exceeding one fails the run,
+// so a regression has to be fixed or the budget raised deliberately.
+
+static std::size_t s_failures = 0;
+
+static void
+expect_at_most(const char* operation, double measured, double budget)
+{
+    bool within = measured <= budget;
+
+    if (!within)
+        ++s_failures;
+
+    std::printf(
+        "%s %-44s %10.4f (at most %.2f)\n",
+        within ? "[ ok ]" : "[FAIL]",
+        operation,
+        measured,
+        budget
+    );
+}
+
+static winsys::KeyEvent
+key_event(winsys::Key key, winsys::EnumSet<winsys::Modifier> modifiers)
+{
+    return winsys::KeyEvent {
+        winsys::KeyCapture {
+            winsys::KeyInput { key, modifiers },
+            std::nullopt
+        }
+    };
+}
+
+static winsys::MouseEvent
+click_event(winsys::Window window)
+{
+    return winsys::MouseEvent {
+        winsys::MouseCapture {
+            winsys::MouseCapture::MouseCaptureKind::Press,
+            winsys::MouseInput {
+                winsys::MouseInput::MouseInputTarget::Client,
+                winsys::Button::Left,
+                {}
+            },
+            window,
+            winsys::Pos { 0, 0 }
+        },
+        false
+    };
+}
+
+static winsys::MouseEvent
+motion_event(winsys::Pos pos)
+{
+    return winsys::MouseEvent {
+        winsys::MouseCapture {
+            winsys::MouseCapture::MouseCaptureKind::Motion,
+            winsys::MouseInput {
+                winsys::MouseInput::MouseInputTarget::Global,
+                winsys::Button::Left,
+                {}
+            },
+            std::nullopt,
+            pos
+        },
+        true
+    };
+}
+
+static std::vector<winsys::Window>
+manage_windows(MockConnection& conn, Model& model, std::size_t count)
+{
+    std::vector<winsys::Window> windows;
+    windows.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+        windows.push_back(conn.create_window(winsys::Region {
+            winsys::Pos { 0, 0 },
+            winsys::Dim { 300, 200 }
+        }));
+
+    model.step();
+    return windows;
+}
+
+static std::size_t
+grab_count(MockConnection const& conn)
+{
+    return conn.request_count(MockConnection::RequestKind::GrabInput)
+        + conn.request_count(MockConnection::RequestKind::UngrabInput);
+}
+
+// Focusing the next client on a MainDeck workspace repaints the borders of
+// the two clients involved, moves input focus, updates _NET_ACTIVE_WINDOW,
+// and raises the newly focused client, as deck clients overlap: 5 requests.
+static void
+test_focus_cycle()
+{
+    static constexpr std::size_t CLIENT_COUNT = 20;
+    static constexpr std::size_t CYCLE_COUNT = 3 * CLIENT_COUNT;
+
+    MockConnection conn({ winsys::Region {
+        winsys::Pos { 0, 0 },
+        winsys::Dim { 1920, 1080 }
+    }});
+
+    Model model(conn);
+    spdlog::set_level(spdlog::level::warn);
+
+    manage_windows(conn, model, CLIENT_COUNT);
+
+    conn.push_event(key_event(winsys::Key::D, { winsys::Main, winsys::Ctrl }));
+    model.step();
+
+    conn.clear_requests();
+
+    for (std::size_t i = 0; i < CYCLE_COUNT; ++i) {
+        conn.push_event(key_event(winsys::Key::J, { winsys::Main }));
+        model.step();
+    }
+
+    expect_at_most(
+        "requests per focus cycle (20-window MainDeck)",
+        static_cast<double>(conn.request_count()) / CYCLE_COUNT,
+        5
+    );
+
+    expect_at_most(
+        "configures per focus cycle (20-window MainDeck)",
+        static_cast<double>(conn.request_count(MockConnection::RequestKind::ConfigureWindow))
+            / CYCLE_COUNT,
+        0
+    );
+}
+
+// Clicks are caught by a passive grab set up once per frame, so neither
+// cycling focus nor clicking a client to focus it grabs or ungrabs anything.
+static void
+test_focus_grabs()
+{
+    static constexpr std::size_t CLIENT_COUNT = 20;
+
+    MockConnection conn({ winsys::Region {
+        winsys::Pos { 0, 0 },
+        winsys::Dim { 1920, 1080 }
+    }});
+
+    Model model(conn);
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<winsys::Window> windows = manage_windows(conn, model, CLIENT_COUNT);
+
+    conn.clear_requests();
+
+    for (std::size_t i = 0; i < CLIENT_COUNT; ++i) {
+        conn.push_event(key_event(winsys::Key::J, { winsys::Main }));
+        model.step();
+    }
+
+    expect_at_most(
+        "grabs per focus cycle",
+        static_cast<double>(grab_count(conn)) / CLIENT_COUNT,
+        0
+    );
+
+    conn.clear_requests();
+
+    for (winsys::Window window : windows) {
+        conn.push_event(click_event(window));
+        model.step();
+    }
+
+    expect_at_most(
+        "grabs per click to focus",
+        static_cast<double>(grab_count(conn)) / CLIENT_COUNT,
+        0
+    );
+
+    // the first click may land on the client that already has focus
+    expect_at_most(
+        "clicks that did not move focus",
+        static_cast<double>(CLIENT_COUNT)
+            - conn.request_count(MockConnection::RequestKind::SetInputFocus),
+        1
+    );
+}
+
+// Dispatching a motion event allocates nothing, whether the pointer merely
+// moves or drags a client. Events are queued before counting starts, so that
+// only the model's handling of them is measured.
+static void
+test_motion_allocations()
+{
+    static constexpr std::size_t MOTION_COUNT = 256;
+
+    MockConnection conn({ winsys::Region {
+        winsys::Pos { 0, 0 },
+        winsys::Dim { 1920, 1080 }
+    }});
+
+    Model model(conn);
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<winsys::Window> windows = manage_windows(conn, model, 5);
+
+    auto allocations_per_motion = [&]() -> double {
+        // a first batch brings reused buffers up to their working size
+        for (std::size_t i = 0; i < MOTION_COUNT; ++i)
+            conn.push_event(motion_event(winsys::Pos { 100 + static_cast<int>(i), 100 }));
+
+        model.step();
+
+        for (std::size_t i = 0; i < MOTION_COUNT; ++i)
+            conn.push_event(motion_event(winsys::Pos { 100, 100 + static_cast<int>(i) }));
+
+        std::size_t allocations = allocation_count();
+        model.step();
+
+        return static_cast<double>(allocation_count() - allocations) / MOTION_COUNT;
+    };
+
+    expect_at_most("allocations per motion event", allocations_per_motion(), 0);
+
+    winsys::MouseEvent press = click_event(windows.front());
+    press.capture.input.modifiers = { winsys::Main };
+    conn.push_event(press);
+    model.step();
+
+    conn.clear_requests();
+    expect_at_most("allocations per motion event while moving", allocations_per_motion(), 0);
+
+    // the drag must actually have moved the client for the above to count
+    expect_at_most(
+        "drags that did not move the client",
+        conn.request_count(MockConnection::RequestKind::ConfigureWindow) > 0 ? 0 : 1,
+        0
+    );
+}
+
+int
+main(int, char **)
+{
+    test_focus_cycle();
+    test_focus_grabs();
+    test_motion_allocations();
+
+    if (s_failures > 0) {
+        std::printf("%zu budget(s) exceeded\n", s_failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include "hints.hh"
 #include "message.hh"
 #include "screen.hh"
+#include "snapshot.hh"
 #include "window.hh"
 
 #include <functional>
@@ -27,9 +28,12 @@ namespace winsys
         virtual bool flush() = 0;
         virtual Event step() = 0;
         virtual bool check_progress() = 0;
-        virtual void process_events(std::function<void(Event)>) = 0;
-        virtual void process_messages(std::function<void(Message)>) = 0;
+        virtual void process_events(std::function<void(Event)> const&) = 0;
+        virtual void process_messages(std::function<void(Message)> const&) = 0;
+        virtual void watch_fd(int, std::function<void()>) = 0;
+        virtual void unwatch_fd(int) = 0;
         virtual std::vector<Screen> connected_outputs() = 0;
+        virtual unsigned get_refresh_rate() = 0;
         virtual std::vector<Window> top_level_windows() = 0;
         virtual Pos get_pointer_position() = 0;
         virtual void warp_pointer_center_of_window_or_root(std::optional<Window>, Screen&) = 0;
@@ -37,12 +41,13 @@ namespace winsys
         virtual void warp_pointer_rpos(Window, Pos) = 0;
         virtual void confine_pointer(Window) = 0;
         virtual bool release_pointer() = 0;
-        virtual void call_external_command(std::string&) = 0;
         virtual void cleanup() = 0;
 
         // window manipulation
         virtual Window create_frame(Region) = 0;
+        virtual void release_frame(Window) = 0;
         virtual void init_window(Window) = 0;
+        virtual bool init_sync_request(Window) = 0;
         virtual void init_frame(Window, bool) = 0;
         virtual void init_unmanaged(Window) = 0;
         virtual void init_move(Window) = 0;
@@ -58,26 +63,27 @@ namespace winsys
         virtual void place_window(Window, Region&) = 0;
         virtual void move_window(Window, Pos) = 0;
         virtual void resize_window(Window, Dim) = 0;
+        virtual void send_sync_request(Window) = 0;
         virtual void focus_window(Window) = 0;
         virtual void stack_window_above(Window, std::optional<Window>) = 0;
         virtual void stack_window_below(Window, std::optional<Window>) = 0;
         virtual void insert_window_in_save_set(Window) = 0;
         virtual void grab_bindings(std::vector<KeyInput>&, std::vector<MouseInput>&) = 0;
-        virtual void regrab_buttons(Window) = 0;
-        virtual void ungrab_buttons(Window) = 0;
         virtual void unfocus() = 0;
         virtual void set_window_border_width(Window, unsigned) = 0;
         virtual void set_window_border_color(Window, unsigned) = 0;
         virtual void set_window_background_color(Window, unsigned) = 0;
         virtual void set_window_notify_enter(Window, bool) = 0;
-        virtual void update_window_offset(Window, Window) = 0;
+        virtual void update_window_offset(Window, Region) = 0;
+        virtual void update_window_offsets(std::vector<std::pair<Window, Region>> const&) = 0;
         virtual Window get_focused_window() = 0;
         virtual std::optional<Region> get_window_geometry(Window) = 0;
         virtual std::optional<Pid> get_window_pid(Window) = 0;
-        virtual std::optional<Pid> get_ppid(std::optional<Pid>) = 0;
         virtual bool must_manage_window(Window) = 0;
         virtual bool must_free_window(Window) = 0;
         virtual bool window_is_mappable(Window) = 0;
+        virtual WindowSnapshot fetch_window_snapshot(Window) = 0;
+        virtual std::vector<WindowSnapshot> fetch_window_snapshots(std::vector<Window> const&) = 0;
 
         // ICCCM
         virtual void set_icccm_window_state(Window, IcccmWindowState) = 0;
@@ -106,8 +112,8 @@ namespace winsys
         virtual std::optional<std::vector<std::optional<Strut>>> get_window_strut(Window) = 0;
         virtual std::optional<std::vector<std::optional<Strut>>> get_window_strut_partial(Window) = 0;
         virtual std::optional<Index> get_window_desktop(Window) = 0;
-        virtual std::unordered_set<WindowType> get_window_types(Window) = 0;
-        virtual std::unordered_set<WindowState> get_window_states(Window) = 0;
+        virtual EnumSet<WindowType> get_window_types(Window) = 0;
+        virtual EnumSet<WindowState> get_window_states(Window) = 0;
         virtual bool window_is_fullscreen(Window) = 0;
         virtual bool window_is_above(Window) = 0;
         virtual bool window_is_below(Window) = 0;
@@ -23,18 +23,42 @@ namespace winsys
         Color urgent;
     };
 
+    inline bool
+    operator==(ColorScheme const& lhs, ColorScheme const& rhs)
+    {
+        return lhs.focused == rhs.focused
+            && lhs.fdisowned == rhs.fdisowned
+            && lhs.fsticky == rhs.fsticky
+            && lhs.unfocused == rhs.unfocused
+            && lhs.udisowned == rhs.udisowned
+            && lhs.usticky == rhs.usticky
+            && lhs.urgent == rhs.urgent;
+    }
+
     struct Border final
     {
         unsigned width;
         ColorScheme colors;
     };
 
+    inline bool
+    operator==(Border const& lhs, Border const& rhs)
+    {
+        return lhs.width == rhs.width && lhs.colors == rhs.colors;
+    }
+
     struct Frame final
     {
         Extents extents;
         ColorScheme colors;
     };
 
+    inline bool
+    operator==(Frame const& lhs, Frame const& rhs)
+    {
+        return lhs.extents == rhs.extents && lhs.colors == rhs.colors;
+    }
+
     struct Decoration final
     {
         static const Decoration NO_DECORATION;
@@ -46,6 +70,12 @@ namespace winsys
         const Extents extents() const;
     };
 
+    inline bool
+    operator==(Decoration const& lhs, Decoration const& rhs)
+    {
+        return lhs.border == rhs.border && lhs.frame == rhs.frame;
+    }
+
 }
 
 #endif//__WINSYS_DECORATION_H_GUARD__
@@ -0,0 +1,133 @@
+#ifndef __WINSYS_ENUMSET_H_GUARD__
+#define __WINSYS_ENUMSET_H_GUARD__
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+namespace winsys
+{
+
+    // Marks enumerations whose enumerators are single-bit flags, rather than
+    // consecutive indices.
+    template <typename T>
+    struct EnumFlags : std::false_type {};
+
+    // A set of enumerators held in a single word. It offers the parts of the
+    // std::unordered_set interface the window manager relies on, but never
+    // allocates, is trivially copyable, and can be built at compile time.
+    template <typename T>
+    class EnumSet final
+    {
+        static_assert(std::is_enum_v<T>);
+
+    public:
+        typedef std::uint64_t Bits;
+        typedef T value_type;
+
+        class const_iterator final
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef T const* pointer;
+            typedef T reference;
+
+            constexpr const_iterator(): m_bits(0) {}
+            constexpr explicit const_iterator(Bits bits): m_bits(bits) {}
+
+            constexpr T
+            operator*() const
+            {
+                return EnumSet::value(std::countr_zero(m_bits));
+            }
+
+            constexpr const_iterator&
+            operator++()
+            {
+                m_bits &= m_bits - 1;
+                return *this;
+            }
+
+            constexpr const_iterator
+            operator++(int)
+            {
+                const_iterator iter = *this;
+                ++*this;
+                return iter;
+            }
+
+            constexpr bool operator==(const_iterator const&) const = default;
+
+        private:
+            Bits m_bits;
+        };
+
+        typedef const_iterator iterator;
+
+        constexpr EnumSet(): m_bits(0) {}
+
+        constexpr EnumSet(std::initializer_list<T> values)
+            : m_bits(0)
+        {
+            for (T value : values)
+                insert(value);
+        }
+
+        constexpr Bits bits() const { return m_bits; }
+        constexpr bool empty() const { return m_bits == 0; }
+        constexpr std::size_t size() const { return std::popcount(m_bits); }
+
+        constexpr bool
+        contains(T value) const
+        {
+            return (m_bits & bit(value)) != 0;
+        }
+
+        constexpr std::size_t
+        count(T value) const
+        {
+            return contains(value) ? 1 : 0;
+        }
+
+        constexpr void insert(T value) { m_bits |= bit(value); }
+        constexpr void erase(T value) { m_bits &= ~bit(value); }
+        constexpr void clear() { m_bits = 0; }
+
+        constexpr const_iterator begin() const { return const_iterator(m_bits); }
+        constexpr const_iterator end() const { return const_iterator(); }
+
+        constexpr bool operator==(EnumSet const&) const = default;
+
+    private:
+        Bits m_bits;
+
+        static constexpr Bits
+        bit(T value)
+        {
+            Bits raw = static_cast<Bits>(value);
+
+            if constexpr (EnumFlags<T>::value)
+                return raw;
+            else
+                return Bits{1} << raw;
+        }
+
+        static constexpr T
+        value(std::size_t index)
+        {
+            if constexpr (EnumFlags<T>::value)
+                return static_cast<T>(Bits{1} << index);
+            else
+                return static_cast<T>(index);
+        }
+
+    };
+
+}
+
+#endif//__WINSYS_ENUMSET_H_GUARD__
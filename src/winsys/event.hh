@@ -8,6 +8,7 @@
 
 #include <cstdlib>
 #include <optional>
+#include <type_traits>
 #include <variant>
 
 namespace winsys
@@ -151,6 +152,11 @@ namespace winsys
 
     struct ScreenChangeEvent final {};
 
+    struct SyncEvent final
+    {
+        Window window;
+    };
+
     typedef std::variant<
         std::monostate,
         MouseEvent,
@@ -172,9 +178,13 @@ namespace winsys
         ConfigureEvent,
         PropertyEvent,
         FrameExtentsRequestEvent,
-        ScreenChangeEvent
+        ScreenChangeEvent,
+        SyncEvent
     > Event;
 
+    // events are passed around by value, which must never allocate
+    static_assert(std::is_trivially_copyable_v<Event>);
+
 }
 
 #endif//__WINSYS_EVENT_H_GUARD__
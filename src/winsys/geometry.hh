@@ -126,6 +126,15 @@ namespace winsys
 
     typedef Padding Extents;
 
+    inline bool
+    operator==(Padding const& lhs, Padding const& rhs)
+    {
+        return lhs.left == rhs.left
+            && lhs.right == rhs.right
+            && lhs.top == rhs.top
+            && lhs.bottom == rhs.bottom;
+    }
+
     inline std::ostream&
     operator<<(std::ostream& os, Padding const& padding) {
         return os << "[" << padding.left
@@ -2,12 +2,13 @@
 #define __WINSYS_INPUT_H_GUARD__
 
 #include "common.hh"
+#include "enumset.hh"
 #include "window.hh"
 #include "geometry.hh"
 
-#include <unordered_set>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
-#include <numeric>
 
 namespace winsys
 {
@@ -200,6 +201,9 @@ namespace winsys
 		LaunchApp9
     };
 
+    constexpr std::size_t KEY_COUNT
+        = static_cast<std::size_t>(Key::LaunchApp9) + 1;
+
     enum class Button
     {
         Left,
@@ -229,6 +233,9 @@ namespace winsys
 #endif
     };
 
+    template <>
+    struct EnumFlags<Modifier> : std::true_type {};
+
     inline Modifier
     operator|(Modifier lhs, Modifier rhs)
     {
@@ -241,7 +248,7 @@ namespace winsys
     struct KeyInput final
     {
         Key key;
-        std::unordered_set<Modifier> modifiers;
+        EnumSet<Modifier> modifiers;
     };
 
     struct KeyCapture final
@@ -261,7 +268,7 @@ namespace winsys
 
         MouseInputTarget target;
         Button button;
-        std::unordered_set<Modifier> modifiers;
+        EnumSet<Modifier> modifiers;
     };
 
     struct MouseCapture final
@@ -353,13 +360,8 @@ namespace std
         operator()(winsys::KeyInput const& input) const
         {
             std::size_t key_hash = std::hash<winsys::Key>()(input.key);
-            std::size_t modifiers_hash = std::hash<std::size_t>()(
-                std::accumulate(
-                    input.modifiers.begin(),
-                    input.modifiers.end(),
-                    static_cast<winsys::Modifier>(0),
-                    std::bit_or<winsys::Modifier>()
-                )
+            std::size_t modifiers_hash = std::hash<std::uint64_t>()(
+                input.modifiers.bits()
             );
 
             return key_hash ^ modifiers_hash;
@@ -377,13 +379,8 @@ namespace std
         {
             std::size_t target_hash = std::hash<winsys::MouseInput::MouseInputTarget>()(input.target);
             std::size_t button_hash = std::hash<winsys::Button>()(input.button);
-            std::size_t modifiers_hash = std::hash<std::size_t>()(
-                std::accumulate(
-                    input.modifiers.begin(),
-                    input.modifiers.end(),
-                    static_cast<winsys::Modifier>(0),
-                    std::bit_or<winsys::Modifier>()
-                )
+            std::size_t modifiers_hash = std::hash<std::uint64_t>()(
+                input.modifiers.bits()
             );
 
             return target_hash ^ button_hash ^ modifiers_hash;
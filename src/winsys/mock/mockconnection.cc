@@ -0,0 +1,973 @@
+#include "mockconnection.hh"
+#include "../util.hh"
+
+#include <algorithm>
+
+extern "C" {
+#include <poll.h>
+}
+
+MockConnection::MockConnection(std::vector<winsys::Region> const& outputs)
+    : m_outputs(outputs),
+      m_next_window(ROOT + 1),
+      m_windows({}),
+      m_stacking_order({}),
+      m_focus(ROOT),
+      m_pointer(winsys::Pos { 0, 0 }),
+      m_confined_to(std::nullopt),
+      m_events({}),
+      m_messages({}),
+      m_fd_watchers({}),
+      m_requests({})
+{}
+
+MockConnection::~MockConnection()
+{}
+
+
+winsys::Window
+MockConnection::create_window(winsys::Region region, bool manageable)
+{
+    winsys::Window window = m_next_window++;
+
+    m_windows[window] = MockWindow {};
+    m_windows[window].region = region;
+    m_windows[window].manageable = manageable;
+    m_stacking_order.push_back(window);
+
+    m_events.push_back(winsys::MapRequestEvent { window, !manageable });
+    return window;
+}
+
+MockConnection::MockWindow*
+MockConnection::get_mock_window(winsys::Window window)
+{
+    auto it = m_windows.find(window);
+    return it != m_windows.end() ? &it->second : nullptr;
+}
+
+void
+MockConnection::push_event(winsys::Event event)
+{
+    m_events.push_back(event);
+}
+
+void
+MockConnection::push_message(winsys::Message message)
+{
+    m_messages.push_back(message);
+}
+
+std::vector<MockConnection::Request> const&
+MockConnection::requests() const
+{
+    return m_requests;
+}
+
+std::size_t
+MockConnection::request_count() const
+{
+    return m_requests.size();
+}
+
+std::size_t
+MockConnection::request_count(RequestKind kind) const
+{
+    return std::count_if(
+        m_requests.begin(),
+        m_requests.end(),
+        [kind](Request const& request) -> bool {
+            return request.kind == kind;
+        }
+    );
+}
+
+void
+MockConnection::clear_requests()
+{
+    m_requests.clear();
+}
+
+std::vector<winsys::Window> const&
+MockConnection::stacking_order() const
+{
+    return m_stacking_order;
+}
+
+
+void
+MockConnection::init_wm_ipc()
+{}
+
+bool
+MockConnection::flush()
+{
+    return true;
+}
+
+winsys::Event
+MockConnection::step()
+{
+    if (m_events.empty())
+        return std::monostate{};
+
+    winsys::Event event = m_events.front();
+    m_events.pop_front();
+
+    return event;
+}
+
+bool
+MockConnection::check_progress()
+{
+    // watched descriptors are polled, but never waited on, so that a
+    // scripted run does not block
+    std::vector<struct pollfd>& fds = m_poll_fds;
+    fds.clear();
+
+    for (auto& [fd,_] : m_fd_watchers)
+        fds.push_back(pollfd { fd, POLLIN, 0 });
+
+    if (!fds.empty() && poll(fds.data(), fds.size(), 0) > 0)
+        for (struct pollfd& fd : fds)
+            if ((fd.revents & POLLIN) && m_fd_watchers.count(fd.fd) > 0) {
+                std::function<void()> callback = m_fd_watchers.at(fd.fd);
+                callback();
+            }
+
+    return !m_events.empty() || !m_messages.empty();
+}
+
+void
+MockConnection::process_events(std::function<void(winsys::Event)> const& callback)
+{
+    while (!m_events.empty())
+        callback(step());
+}
+
+void
+MockConnection::process_messages(std::function<void(winsys::Message)> const& callback)
+{
+    while (!m_messages.empty()) {
+        winsys::Message message = std::move(m_messages.front());
+        m_messages.pop_front();
+        callback(std::move(message));
+    }
+}
+
+void
+MockConnection::watch_fd(int fd, std::function<void()> callback)
+{
+    m_fd_watchers[fd] = callback;
+}
+
+void
+MockConnection::unwatch_fd(int fd)
+{
+    m_fd_watchers.erase(fd);
+}
+
+std::vector<winsys::Screen>
+MockConnection::connected_outputs()
+{
+    std::vector<winsys::Screen> screens;
+    screens.reserve(m_outputs.size());
+
+    for (std::size_t i = 0; i < m_outputs.size(); ++i)
+        screens.emplace_back(i, m_outputs[i]);
+
+    return screens;
+}
+
+unsigned
+MockConnection::get_refresh_rate()
+{
+    return 60;
+}
+
+std::vector<winsys::Window>
+MockConnection::top_level_windows()
+{
+    record(RequestKind::Query, ROOT);
+
+    std::vector<winsys::Window> windows;
+    std::copy_if(
+        m_stacking_order.begin(),
+        m_stacking_order.end(),
+        std::back_inserter(windows),
+        [this](winsys::Window window) -> bool {
+            return !m_windows.at(window).parent;
+        }
+    );
+
+    return windows;
+}
+
+winsys::Pos
+MockConnection::get_pointer_position()
+{
+    return m_pointer;
+}
+
+void
+MockConnection::warp_pointer_center_of_window_or_root(std::optional<winsys::Window> window, winsys::Screen& screen)
+{
+    winsys::Region region = screen.full_region();
+
+    if (window && m_windows.count(*window))
+        region = m_windows.at(*window).region;
+
+    warp_pointer(winsys::Pos {
+        region.pos.x + region.dim.w / 2,
+        region.pos.y + region.dim.h / 2
+    });
+}
+
+void
+MockConnection::warp_pointer(winsys::Pos pos)
+{
+    record(RequestKind::WarpPointer, ROOT);
+    m_pointer = pos;
+}
+
+void
+MockConnection::warp_pointer_rpos(winsys::Window window, winsys::Pos pos)
+{
+    if (!m_windows.count(window))
+        return;
+
+    winsys::Pos origin = m_windows.at(window).region.pos;
+
+    warp_pointer(winsys::Pos {
+        origin.x + pos.x,
+        origin.y + pos.y
+    });
+}
+
+void
+MockConnection::confine_pointer(winsys::Window window)
+{
+    if (!m_confined_to) {
+        record(RequestKind::GrabInput, window);
+        m_confined_to = window;
+    }
+}
+
+bool
+MockConnection::release_pointer()
+{
+    if (m_confined_to) {
+        record(RequestKind::UngrabInput, *m_confined_to);
+        m_confined_to = std::nullopt;
+        return true;
+    }
+
+    return false;
+}
+
+void
+MockConnection::cleanup()
+{
+    m_windows.clear();
+    m_stacking_order.clear();
+    m_events.clear();
+    m_messages.clear();
+}
+
+
+winsys::Window
+MockConnection::create_frame(winsys::Region region)
+{
+    winsys::Window frame = m_next_window++;
+    record(RequestKind::CreateFrame, frame);
+    record(RequestKind::GrabInput, frame);
+
+    m_windows[frame] = MockWindow {};
+    m_windows[frame].region = region;
+    m_windows[frame].frame = true;
+    m_stacking_order.push_back(frame);
+
+    return frame;
+}
+
+void
+MockConnection::release_frame(winsys::Window frame)
+{
+    destroy_window(frame);
+}
+
+void
+MockConnection::init_window(winsys::Window window)
+{
+    record(RequestKind::ChangeWindowAttributes, window);
+}
+
+bool
+MockConnection::init_sync_request(winsys::Window window)
+{
+    record(RequestKind::Query, window);
+
+    MockWindow* mock = get_mock_window(window);
+    return mock && mock->sync_request;
+}
+
+void
+MockConnection::init_frame(winsys::Window window, bool)
+{
+    record(RequestKind::ChangeWindowAttributes, window);
+}
+
+void
+MockConnection::init_unmanaged(winsys::Window window)
+{
+    record(RequestKind::ChangeWindowAttributes, window);
+}
+
+void
+MockConnection::init_move(winsys::Window window)
+{
+    confine_pointer(window);
+}
+
+void
+MockConnection::init_resize(winsys::Window window)
+{
+    confine_pointer(window);
+}
+
+void
+MockConnection::cleanup_window(winsys::Window window)
+{
+    if (m_focus == window)
+        m_focus = ROOT;
+}
+
+void
+MockConnection::map_window(winsys::Window window)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::MapWindow, window);
+
+    if (!mock->mapped) {
+        mock->mapped = true;
+
+        if (!mock->parent || !m_windows.at(*mock->parent).frame)
+            m_events.push_back(winsys::MapEvent { window, !mock->manageable });
+    }
+}
+
+void
+MockConnection::unmap_window(winsys::Window window)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::UnmapWindow, window);
+
+    if (mock->mapped) {
+        mock->mapped = false;
+
+        if (!mock->parent || !m_windows.at(*mock->parent).frame)
+            m_events.push_back(winsys::UnmapEvent { window, !mock->manageable });
+    }
+}
+
+void
+MockConnection::reparent_window(winsys::Window window, winsys::Window parent, winsys::Pos pos)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ReparentWindow, window);
+    mock->parent = parent;
+    mock->region.pos = pos;
+    Util::erase_remove(m_stacking_order, window);
+}
+
+void
+MockConnection::unparent_window(winsys::Window window, winsys::Pos pos)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ReparentWindow, window);
+    mock->parent = std::nullopt;
+    mock->region.pos = pos;
+    m_stacking_order.push_back(window);
+}
+
+void
+MockConnection::destroy_window(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return;
+
+    record(RequestKind::DestroyWindow, window);
+
+    for (auto& [_, mock] : m_windows)
+        if (mock.parent == window)
+            mock.parent = std::nullopt;
+
+    if (m_focus == window)
+        m_focus = ROOT;
+
+    m_windows.erase(window);
+    Util::erase_remove(m_stacking_order, window);
+}
+
+bool
+MockConnection::close_window(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return false;
+
+    record(RequestKind::CloseWindow, window);
+    m_events.push_back(winsys::DestroyEvent { window });
+    return true;
+}
+
+bool
+MockConnection::kill_window(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return false;
+
+    record(RequestKind::KillWindow, window);
+    m_events.push_back(winsys::DestroyEvent { window });
+    return true;
+}
+
+void
+MockConnection::place_window(winsys::Window window, winsys::Region& region)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ConfigureWindow, window);
+    mock->region = region;
+}
+
+void
+MockConnection::move_window(winsys::Window window, winsys::Pos pos)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ConfigureWindow, window);
+    mock->region.pos = pos;
+}
+
+void
+MockConnection::resize_window(winsys::Window window, winsys::Dim dim)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ConfigureWindow, window);
+    mock->region.dim = dim;
+}
+
+void
+MockConnection::send_sync_request(winsys::Window window)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock || !mock->sync_request)
+        return;
+
+    record(RequestKind::SendEvent, window);
+}
+
+void
+MockConnection::focus_window(winsys::Window window)
+{
+    record(RequestKind::SetInputFocus, window);
+    m_focus = window;
+}
+
+void
+MockConnection::stack_window_above(winsys::Window window, std::optional<winsys::Window> sibling)
+{
+    restack(window, sibling, true);
+}
+
+void
+MockConnection::stack_window_below(winsys::Window window, std::optional<winsys::Window> sibling)
+{
+    restack(window, sibling, false);
+}
+
+void
+MockConnection::insert_window_in_save_set(winsys::Window window)
+{
+    record(RequestKind::ChangeSaveSet, window);
+}
+
+void
+MockConnection::grab_bindings(std::vector<winsys::KeyInput>&, std::vector<winsys::MouseInput>&)
+{
+    record(RequestKind::GrabInput, ROOT);
+}
+
+void
+MockConnection::unfocus()
+{
+    record(RequestKind::SetInputFocus, ROOT);
+    m_focus = ROOT;
+}
+
+void
+MockConnection::set_window_border_width(winsys::Window window, unsigned width)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ConfigureWindow, window);
+    mock->border_width = width;
+}
+
+void
+MockConnection::set_window_border_color(winsys::Window window, unsigned color)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeWindowAttributes, window);
+    mock->border_color = color;
+}
+
+void
+MockConnection::set_window_background_color(winsys::Window window, unsigned color)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeWindowAttributes, window);
+    mock->background_color = color;
+}
+
+void
+MockConnection::set_window_notify_enter(winsys::Window window, bool notify_enter)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeWindowAttributes, window);
+    mock->notify_enter = notify_enter;
+}
+
+void
+MockConnection::update_window_offset(winsys::Window window, winsys::Region offset)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock || mock->offset == offset)
+        return;
+
+    // the synthetic ConfigureNotify sent to the client
+    record(RequestKind::SendEvent, window);
+    mock->offset = offset;
+}
+
+void
+MockConnection::update_window_offsets(std::vector<std::pair<winsys::Window, winsys::Region>> const& offsets)
+{
+    for (auto& [window,offset] : offsets)
+        update_window_offset(window, offset);
+}
+
+winsys::Window
+MockConnection::get_focused_window()
+{
+    return m_focus;
+}
+
+std::optional<winsys::Region>
+MockConnection::get_window_geometry(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).region;
+}
+
+std::optional<winsys::Pid>
+MockConnection::get_window_pid(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).pid;
+}
+
+bool
+MockConnection::must_manage_window(winsys::Window window)
+{
+    return m_windows.count(window) && m_windows.at(window).manageable;
+}
+
+bool
+MockConnection::must_free_window(winsys::Window window)
+{
+    return m_windows.count(window) && m_windows.at(window).free;
+}
+
+bool
+MockConnection::window_is_mappable(winsys::Window window)
+{
+    return m_windows.count(window) > 0;
+}
+
+winsys::WindowSnapshot
+MockConnection::fetch_window_snapshot(winsys::Window window)
+{
+    winsys::WindowSnapshot snapshot{};
+    snapshot.window = window;
+
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return snapshot;
+
+    record(RequestKind::Query, window);
+
+    snapshot.geometry = mock->region;
+    snapshot.mappable = true;
+    snapshot.manageable = mock->manageable;
+    snapshot.must_free = mock->free;
+    snapshot.pid = mock->pid;
+    snapshot.name = mock->name;
+    snapshot.class_ = mock->class_;
+    snapshot.instance = mock->instance;
+    snapshot.types = mock->types;
+    snapshot.states = mock->states;
+    snapshot.desktop = mock->desktop;
+    snapshot.hints = mock->hints;
+    snapshot.size_hints = mock->size_hints;
+    snapshot.transient_for = mock->transient_for;
+    snapshot.client_leader = mock->client_leader;
+    snapshot.struts = mock->struts;
+
+    return snapshot;
+}
+
+std::vector<winsys::WindowSnapshot>
+MockConnection::fetch_window_snapshots(std::vector<winsys::Window> const& windows)
+{
+    std::vector<winsys::WindowSnapshot> snapshots;
+    snapshots.reserve(windows.size());
+
+    for (winsys::Window window : windows)
+        snapshots.push_back(fetch_window_snapshot(window));
+
+    return snapshots;
+}
+
+
+void
+MockConnection::set_icccm_window_state(winsys::Window window, winsys::IcccmWindowState state)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    if (state == winsys::IcccmWindowState::Withdrawn) {
+        record(RequestKind::DeleteProperty, window);
+        mock->icccm_state = std::nullopt;
+    } else {
+        record(RequestKind::ChangeProperty, window);
+        mock->icccm_state = state;
+    }
+}
+
+void
+MockConnection::set_icccm_window_hints(winsys::Window window, winsys::Hints hints)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeProperty, window);
+    mock->hints = hints;
+}
+
+std::string
+MockConnection::get_icccm_window_name(winsys::Window window)
+{
+    return m_windows.count(window) ? m_windows.at(window).name : "";
+}
+
+std::string
+MockConnection::get_icccm_window_class(winsys::Window window)
+{
+    return m_windows.count(window) ? m_windows.at(window).class_ : "";
+}
+
+std::string
+MockConnection::get_icccm_window_instance(winsys::Window window)
+{
+    return m_windows.count(window) ? m_windows.at(window).instance : "";
+}
+
+std::optional<winsys::Window>
+MockConnection::get_icccm_window_transient_for(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).transient_for;
+}
+
+std::optional<winsys::Window>
+MockConnection::get_icccm_window_client_leader(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).client_leader;
+}
+
+std::optional<winsys::Hints>
+MockConnection::get_icccm_window_hints(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).hints;
+}
+
+std::optional<winsys::SizeHints>
+MockConnection::get_icccm_window_size_hints(winsys::Window window, std::optional<winsys::Dim>)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).size_hints;
+}
+
+
+void
+MockConnection::init_for_wm(std::vector<std::string> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::set_current_desktop(Index)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::set_root_window_name(std::string const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::set_window_desktop(winsys::Window window, Index index)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeProperty, window);
+    mock->desktop = index;
+}
+
+void
+MockConnection::set_window_state(winsys::Window window, winsys::WindowState state, bool on)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeProperty, window);
+
+    if (on)
+        mock->states.insert(state);
+    else
+        mock->states.erase(state);
+}
+
+void
+MockConnection::set_window_frame_extents(winsys::Window window, winsys::Extents extents)
+{
+    MockWindow* mock = get_mock_window(window);
+
+    if (!mock)
+        return;
+
+    record(RequestKind::ChangeProperty, window);
+    mock->frame_extents = extents;
+}
+
+void
+MockConnection::set_desktop_geometry(std::vector<winsys::Region> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::set_desktop_viewport(std::vector<winsys::Region> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::set_workarea(std::vector<winsys::Region> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::update_desktops(std::vector<std::string> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::update_client_list(std::vector<winsys::Window> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+void
+MockConnection::update_client_list_stacking(std::vector<winsys::Window> const&)
+{
+    record(RequestKind::ChangeProperty, ROOT);
+}
+
+std::optional<std::vector<std::optional<winsys::Strut>>>
+MockConnection::get_window_strut(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).struts;
+}
+
+std::optional<std::vector<std::optional<winsys::Strut>>>
+MockConnection::get_window_strut_partial(winsys::Window window)
+{
+    return get_window_strut(window);
+}
+
+std::optional<Index>
+MockConnection::get_window_desktop(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return std::nullopt;
+
+    return m_windows.at(window).desktop;
+}
+
+winsys::EnumSet<winsys::WindowType>
+MockConnection::get_window_types(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return {};
+
+    return m_windows.at(window).types;
+}
+
+winsys::EnumSet<winsys::WindowState>
+MockConnection::get_window_states(winsys::Window window)
+{
+    if (!m_windows.count(window))
+        return {};
+
+    return m_windows.at(window).states;
+}
+
+bool
+MockConnection::window_is_fullscreen(winsys::Window window)
+{
+    return get_window_states(window).count(winsys::WindowState::Fullscreen) > 0;
+}
+
+bool
+MockConnection::window_is_above(winsys::Window window)
+{
+    return get_window_states(window).count(winsys::WindowState::Above_) > 0;
+}
+
+bool
+MockConnection::window_is_below(winsys::Window window)
+{
+    return get_window_states(window).count(winsys::WindowState::Below_) > 0;
+}
+
+bool
+MockConnection::window_is_sticky(winsys::Window window)
+{
+    return get_window_states(window).count(winsys::WindowState::Sticky) > 0;
+}
+
+
+void
+MockConnection::init_for_client()
+{}
+
+
+void
+MockConnection::record(RequestKind kind, winsys::Window window)
+{
+    m_requests.push_back(Request { kind, window });
+}
+
+void
+MockConnection::restack(winsys::Window window, std::optional<winsys::Window> sibling, bool above)
+{
+    if (!m_windows.count(window))
+        return;
+
+    record(RequestKind::RestackWindow, window);
+    Util::erase_remove(m_stacking_order, window);
+
+    auto it = sibling
+        ? std::find(m_stacking_order.begin(), m_stacking_order.end(), *sibling)
+        : m_stacking_order.end();
+
+    if (it == m_stacking_order.end()) {
+        if (above)
+            m_stacking_order.push_back(window);
+        else
+            m_stacking_order.insert(m_stacking_order.begin(), window);
+
+        return;
+    }
+
+    if (above)
+        ++it;
+
+    m_stacking_order.insert(it, window);
+}
@@ -0,0 +1,224 @@
+#ifndef __WINSYS_MOCK_MOCKCONNECTION_H_GUARD__
+#define __WINSYS_MOCK_MOCKCONNECTION_H_GUARD__
+
+#include "../connection.hh"
+#include "../event.hh"
+#include "../input.hh"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <poll.h>
+
+// An in-memory windowing system. Windows, their properties, the stacking
+// order, input focus and the pointer are simulated without a display, and
+// every call that would reach the server is recorded, so that the core can be
+// driven by scripted events and the requests it emits can be inspected.
+class MockConnection final: public winsys::Connection
+{
+public:
+    enum class RequestKind
+    {
+        CreateFrame,
+        MapWindow,
+        UnmapWindow,
+        ReparentWindow,
+        DestroyWindow,
+        CloseWindow,
+        KillWindow,
+        ConfigureWindow,
+        RestackWindow,
+        SetInputFocus,
+        ChangeSaveSet,
+        GrabInput,
+        UngrabInput,
+        WarpPointer,
+        ChangeWindowAttributes,
+        ChangeProperty,
+        DeleteProperty,
+        SendEvent,
+        Query
+    };
+
+    struct Request final
+    {
+        RequestKind kind;
+        winsys::Window window;
+    };
+
+    struct MockWindow final
+    {
+        winsys::Region region;
+        std::optional<winsys::Window> parent;
+        bool mapped;
+        bool frame;
+        bool manageable;
+        bool free;
+        std::optional<unsigned> border_width;
+        std::optional<unsigned> border_color;
+        std::optional<unsigned> background_color;
+        bool notify_enter;
+        bool sync_request;
+        std::optional<winsys::Pid> pid;
+        std::string name;
+        std::string class_;
+        std::string instance;
+        winsys::EnumSet<winsys::WindowType> types;
+        winsys::EnumSet<winsys::WindowState> states;
+        std::optional<Index> desktop;
+        std::optional<winsys::Hints> hints;
+        std::optional<winsys::SizeHints> size_hints;
+        std::optional<winsys::Window> transient_for;
+        std::optional<winsys::Window> client_leader;
+        std::optional<std::vector<std::optional<winsys::Strut>>> struts;
+        std::optional<winsys::IcccmWindowState> icccm_state;
+        std::optional<winsys::Extents> frame_extents;
+        std::optional<winsys::Region> offset;
+    };
+
+    MockConnection(std::vector<winsys::Region> const&);
+    ~MockConnection();
+
+    // scripting
+    winsys::Window create_window(winsys::Region, bool = true);
+    MockWindow* get_mock_window(winsys::Window);
+    void push_event(winsys::Event);
+    void push_message(winsys::Message);
+
+    std::vector<Request> const& requests() const;
+    std::size_t request_count() const;
+    std::size_t request_count(RequestKind) const;
+    void clear_requests();
+
+    std::vector<winsys::Window> const& stacking_order() const;
+
+    virtual void init_wm_ipc() override;
+    virtual bool flush() override;
+    virtual winsys::Event step() override;
+    virtual bool check_progress() override;
+    virtual void process_events(std::function<void(winsys::Event)> const&) override;
+    virtual void process_messages(std::function<void(winsys::Message)> const&) override;
+    virtual void watch_fd(int, std::function<void()>) override;
+    virtual void unwatch_fd(int) override;
+    virtual std::vector<winsys::Screen> connected_outputs() override;
+    virtual unsigned get_refresh_rate() override;
+    virtual std::vector<winsys::Window> top_level_windows() override;
+    virtual winsys::Pos get_pointer_position() override;
+    virtual void warp_pointer_center_of_window_or_root(std::optional<winsys::Window>, winsys::Screen&) override;
+    virtual void warp_pointer(winsys::Pos) override;
+    virtual void warp_pointer_rpos(winsys::Window, winsys::Pos) override;
+    virtual void confine_pointer(winsys::Window) override;
+    virtual bool release_pointer() override;
+    virtual void cleanup() override;
+
+    // window manipulation
+    virtual winsys::Window create_frame(winsys::Region) override;
+    virtual void release_frame(winsys::Window) override;
+    virtual void init_window(winsys::Window) override;
+    virtual bool init_sync_request(winsys::Window) override;
+    virtual void init_frame(winsys::Window, bool) override;
+    virtual void init_unmanaged(winsys::Window) override;
+    virtual void init_move(winsys::Window) override;
+    virtual void init_resize(winsys::Window) override;
+    virtual void cleanup_window(winsys::Window) override;
+    virtual void map_window(winsys::Window) override;
+    virtual void unmap_window(winsys::Window) override;
+    virtual void reparent_window(winsys::Window, winsys::Window, winsys::Pos) override;
+    virtual void unparent_window(winsys::Window, winsys::Pos) override;
+    virtual void destroy_window(winsys::Window) override;
+    virtual bool close_window(winsys::Window) override;
+    virtual bool kill_window(winsys::Window) override;
+    virtual void place_window(winsys::Window, winsys::Region&) override;
+    virtual void move_window(winsys::Window, winsys::Pos) override;
+    virtual void resize_window(winsys::Window, winsys::Dim) override;
+    virtual void send_sync_request(winsys::Window) override;
+    virtual void focus_window(winsys::Window) override;
+    virtual void stack_window_above(winsys::Window, std::optional<winsys::Window>) override;
+    virtual void stack_window_below(winsys::Window, std::optional<winsys::Window>) override;
+    virtual void insert_window_in_save_set(winsys::Window) override;
+    virtual void grab_bindings(std::vector<winsys::KeyInput>&, std::vector<winsys::MouseInput>&) override;
+    virtual void unfocus() override;
+    virtual void set_window_border_width(winsys::Window, unsigned) override;
+    virtual void set_window_border_color(winsys::Window, unsigned) override;
+    virtual void set_window_background_color(winsys::Window, unsigned) override;
+    virtual void set_window_notify_enter(winsys::Window, bool) override;
+    virtual void update_window_offset(winsys::Window, winsys::Region) override;
+    virtual void update_window_offsets(std::vector<std::pair<winsys::Window, winsys::Region>> const&) override;
+    virtual winsys::Window get_focused_window() override;
+    virtual std::optional<winsys::Region> get_window_geometry(winsys::Window) override;
+    virtual std::optional<winsys::Pid> get_window_pid(winsys::Window) override;
+    virtual bool must_manage_window(winsys::Window) override;
+    virtual bool must_free_window(winsys::Window) override;
+    virtual bool window_is_mappable(winsys::Window) override;
+    virtual winsys::WindowSnapshot fetch_window_snapshot(winsys::Window) override;
+    virtual std::vector<winsys::WindowSnapshot> fetch_window_snapshots(std::vector<winsys::Window> const&) override;
+
+    // ICCCM
+    virtual void set_icccm_window_state(winsys::Window, winsys::IcccmWindowState) override;
+    virtual void set_icccm_window_hints(winsys::Window, winsys::Hints) override;
+    virtual std::string get_icccm_window_name(winsys::Window) override;
+    virtual std::string get_icccm_window_class(winsys::Window) override;
+    virtual std::string get_icccm_window_instance(winsys::Window) override;
+    virtual std::optional<winsys::Window> get_icccm_window_transient_for(winsys::Window) override;
+    virtual std::optional<winsys::Window> get_icccm_window_client_leader(winsys::Window) override;
+    virtual std::optional<winsys::Hints> get_icccm_window_hints(winsys::Window) override;
+    virtual std::optional<winsys::SizeHints> get_icccm_window_size_hints(winsys::Window, std::optional<winsys::Dim>) override;
+
+    // EWMH
+    virtual void init_for_wm(std::vector<std::string> const&) override;
+    virtual void set_current_desktop(Index) override;
+    virtual void set_root_window_name(std::string const&) override;
+    virtual void set_window_desktop(winsys::Window, Index) override;
+    virtual void set_window_state(winsys::Window, winsys::WindowState, bool) override;
+    virtual void set_window_frame_extents(winsys::Window, winsys::Extents) override;
+    virtual void set_desktop_geometry(std::vector<winsys::Region> const&) override;
+    virtual void set_desktop_viewport(std::vector<winsys::Region> const&) override;
+    virtual void set_workarea(std::vector<winsys::Region> const&) override;
+    virtual void update_desktops(std::vector<std::string> const&) override;
+    virtual void update_client_list(std::vector<winsys::Window> const&) override;
+    virtual void update_client_list_stacking(std::vector<winsys::Window> const&) override;
+    virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut(winsys::Window) override;
+    virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut_partial(winsys::Window) override;
+    virtual std::optional<Index> get_window_desktop(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowType> get_window_types(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowState> get_window_states(winsys::Window) override;
+    virtual bool window_is_fullscreen(winsys::Window) override;
+    virtual bool window_is_above(winsys::Window) override;
+    virtual bool window_is_below(winsys::Window) override;
+    virtual bool window_is_sticky(winsys::Window) override;
+
+    // IPC client
+    virtual void init_for_client() override;
+
+private:
+    static constexpr winsys::Window ROOT = 1;
+
+    std::vector<winsys::Region> m_outputs;
+    winsys::Window m_next_window;
+
+    std::unordered_map<winsys::Window, MockWindow> m_windows;
+    std::vector<winsys::Window> m_stacking_order;
+
+    winsys::Window m_focus;
+    winsys::Pos m_pointer;
+    std::optional<winsys::Window> m_confined_to;
+
+    std::deque<winsys::Event> m_events;
+    std::deque<winsys::Message> m_messages;
+
+    std::unordered_map<int, std::function<void()>> m_fd_watchers;
+    std::vector<struct pollfd> m_poll_fds;
+
+    std::vector<Request> m_requests;
+
+    void record(RequestKind, winsys::Window);
+    void restack(winsys::Window, std::optional<winsys::Window>, bool);
+};
+
+#endif//__WINSYS_MOCK_MOCKCONNECTION_H_GUARD__
@@ -0,0 +1,40 @@
+#ifndef __WINSYS_SNAPSHOT_H_GUARD__
+#define __WINSYS_SNAPSHOT_H_GUARD__
+
+#include "common.hh"
+#include "enumset.hh"
+#include "geometry.hh"
+#include "hints.hh"
+#include "window.hh"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace winsys
+{
+
+    struct WindowSnapshot final
+    {
+        Window window;
+        std::optional<Region> geometry;
+        bool mappable;
+        bool manageable;
+        bool must_free;
+        std::optional<Pid> pid;
+        std::string name;
+        std::string class_;
+        std::string instance;
+        EnumSet<WindowType> types;
+        EnumSet<WindowState> states;
+        std::optional<Index> desktop;
+        std::optional<Hints> hints;
+        std::optional<SizeHints> size_hints;
+        std::optional<Window> transient_for;
+        std::optional<Window> client_leader;
+        std::optional<std::vector<std::optional<Strut>>> struts;
+    };
+
+}
+
+#endif//__WINSYS_SNAPSHOT_H_GUARD__
@@ -1,6 +1,7 @@
 #ifndef __WINSYS_UTIL_H_GUARD__
 #define __WINSYS_UTIL_H_GUARD__
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
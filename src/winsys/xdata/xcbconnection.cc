@@ -0,0 +1,843 @@
+#include "../common.hh"
+#include "../util.hh"
+#include "xcbconnection.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+#include <X11/Xutil.h>
+}
+
+
+static inline std::uint64_t
+property_key(winsys::Window window, Atom atom)
+{
+    return (static_cast<std::uint64_t>(window) << 32)
+        | static_cast<std::uint64_t>(atom);
+}
+
+static inline winsys::Window
+property_key_window(std::uint64_t key)
+{
+    return static_cast<winsys::Window>(key >> 32);
+}
+
+
+XCBConnection::XCBConnection(const std::string_view wm_name)
+    : XConnection(wm_name),
+      mp_conn(XGetXCBConnection(mp_dpy)),
+      m_property_requests({}),
+      m_geometry_requests({}),
+      m_attributes_requests({}),
+      m_counter_requests({})
+{}
+
+XCBConnection::~XCBConnection()
+{}
+
+
+winsys::Event
+XCBConnection::step()
+{
+    discard_requests();
+
+    winsys::Event event = XConnection::step();
+
+    if (std::holds_alternative<winsys::MapRequestEvent>(event))
+        prefetch_window(std::get<winsys::MapRequestEvent>(event).window);
+
+    return event;
+}
+
+void
+XCBConnection::process_messages(std::function<void(winsys::Message)> const& callback)
+{
+    discard_requests();
+    XConnection::process_messages(callback);
+}
+
+void
+XCBConnection::cleanup()
+{
+    discard_requests();
+    XConnection::cleanup();
+}
+
+
+// window manipulation
+bool
+XCBConnection::init_sync_request(winsys::Window window)
+{
+    if (!m_sync_available)
+        return false;
+
+    std::optional<XSyncCounter> counter = get_sync_counter(window);
+
+    if (!counter)
+        return false;
+
+    xcb_sync_query_counter_reply_t* reply = counter_reply(window);
+
+    if (!reply)
+        return false;
+
+    XSyncValue value;
+    XSyncIntsToValue(&value, reply->counter_value.lo, reply->counter_value.hi);
+
+    return init_sync_alarm(window, *counter, value);
+}
+
+void
+XCBConnection::cleanup_window(winsys::Window window)
+{
+    discard_window(window);
+    XConnection::cleanup_window(window);
+}
+
+std::optional<winsys::Region>
+XCBConnection::get_window_geometry(winsys::Window window)
+{
+    if (WindowShadow* shadow = get_shadow(window); shadow && shadow->region)
+        return shadow->region;
+
+    xcb_get_geometry_reply_t* reply = geometry_reply(window);
+
+    if (!reply)
+        return std::nullopt;
+
+    return winsys::Region {
+        winsys::Pos {
+            reply->x,
+            reply->y
+        },
+        winsys::Dim {
+            reply->width,
+            reply->height
+        }
+    };
+}
+
+bool
+XCBConnection::must_manage_window(winsys::Window window)
+{
+    xcb_get_window_attributes_reply_t* reply = attributes_reply(window);
+
+    return reply
+        && reply->_class != XCB_WINDOW_CLASS_INPUT_ONLY
+        && !reply->override_redirect
+        && !is_unmanaged_window_type(get_window_types(window));
+}
+
+bool
+XCBConnection::must_free_window(winsys::Window window)
+{
+    return is_free_window(
+        get_window_desktop(window),
+        get_window_states(window),
+        get_window_types(window),
+        get_icccm_window_size_hints(window, std::nullopt)
+    );
+}
+
+bool
+XCBConnection::window_is_mappable(winsys::Window window)
+{
+    xcb_get_window_attributes_reply_t* reply = attributes_reply(window);
+    return reply && reply->_class != XCB_WINDOW_CLASS_INPUT_ONLY;
+}
+
+winsys::WindowSnapshot
+XCBConnection::fetch_window_snapshot(winsys::Window window)
+{
+    prefetch_window(window);
+
+    winsys::WindowSnapshot snapshot{};
+    snapshot.window = window;
+    snapshot.geometry = get_window_geometry(window);
+    snapshot.mappable = window_is_mappable(window);
+    snapshot.manageable = snapshot.geometry && must_manage_window(window);
+    snapshot.pid = get_window_pid(window);
+    snapshot.name = get_icccm_window_name(window);
+    snapshot.class_ = get_icccm_window_class(window);
+    snapshot.instance = get_icccm_window_instance(window);
+    snapshot.types = get_window_types(window);
+    snapshot.states = get_window_states(window);
+    snapshot.desktop = get_window_desktop(window);
+    snapshot.hints = get_icccm_window_hints(window);
+    snapshot.size_hints = get_icccm_window_size_hints(window, std::nullopt);
+    snapshot.transient_for = get_icccm_window_transient_for(window);
+    snapshot.client_leader = get_icccm_window_client_leader(window);
+    snapshot.struts = get_window_strut(window);
+
+    snapshot.must_free = is_free_window(
+        snapshot.desktop,
+        snapshot.states,
+        snapshot.types,
+        snapshot.size_hints
+    );
+
+    return snapshot;
+}
+
+std::vector<winsys::WindowSnapshot>
+XCBConnection::fetch_window_snapshots(std::vector<winsys::Window> const& windows)
+{
+    // replies left over from a previous batch are no longer needed
+    discard_requests();
+
+    for (winsys::Window window : windows)
+        prefetch_window(window);
+
+    std::vector<winsys::WindowSnapshot> snapshots
+        = XConnection::fetch_window_snapshots(windows);
+
+    // a sync counter is only known once the properties of its window have
+    // arrived, so the counters of the whole batch are queried in a second
+    // pass, ahead of the init_sync_request calls that need them
+    if (m_sync_available)
+        for (winsys::WindowSnapshot const& snapshot : snapshots)
+            if (snapshot.manageable)
+                request_counter(snapshot.window);
+
+    return snapshots;
+}
+
+
+// ICCCM
+void
+XCBConnection::set_icccm_window_state(winsys::Window window, winsys::IcccmWindowState state)
+{
+    discard_window(window);
+    XConnection::set_icccm_window_state(window, state);
+}
+
+void
+XCBConnection::set_icccm_window_hints(winsys::Window window, winsys::Hints hints)
+{
+    discard_window(window);
+    XConnection::set_icccm_window_hints(window, hints);
+}
+
+std::string
+XCBConnection::get_icccm_window_name(winsys::Window window)
+{
+    std::optional<std::string> name = get_text(window, get_netwm_atom(NetWMID::NetWMName));
+
+    if (!name)
+        name = get_text(window, XA_WM_NAME);
+
+    if (!name || name->empty())
+        return "N/a";
+
+    return *name;
+}
+
+std::string
+XCBConnection::get_icccm_window_class(winsys::Window window)
+{
+    std::optional<std::pair<std::string, std::string>> hint
+        = get_class_hint(window);
+
+    if (!hint || hint->second.empty())
+        return "N/a";
+
+    return hint->second;
+}
+
+std::string
+XCBConnection::get_icccm_window_instance(winsys::Window window)
+{
+    std::optional<std::pair<std::string, std::string>> hint
+        = get_class_hint(window);
+
+    if (!hint || hint->first.empty())
+        return "N/a";
+
+    return hint->first;
+}
+
+std::optional<winsys::Window>
+XCBConnection::get_icccm_window_transient_for(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> values
+        = get_cardlist(window, XA_WM_TRANSIENT_FOR, XA_WINDOW);
+
+    if (!values || values->empty() || (*values)[0] == None)
+        return std::nullopt;
+
+    return (*values)[0];
+}
+
+std::optional<winsys::Window>
+XCBConnection::get_icccm_window_client_leader(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> values
+        = get_cardlist(window, get_netwm_atom(NetWMID::WMClientLeader), XA_WINDOW);
+
+    if (!values || values->empty() || (*values)[0] == None)
+        return std::nullopt;
+
+    return (*values)[0];
+}
+
+std::optional<winsys::Hints>
+XCBConnection::get_icccm_window_hints(winsys::Window window)
+{
+    static constexpr std::size_t hints_elements = 9;
+
+    std::optional<std::vector<std::uint32_t>> values
+        = get_cardlist(window, XA_WM_HINTS, XA_WM_HINTS);
+
+    if (!values || values->size() < hints_elements - 1)
+        return std::nullopt;
+
+    XWMHints hints;
+    hints.flags = (*values)[0];
+    hints.input = (*values)[1] ? True : False;
+    hints.initial_state = static_cast<int>((*values)[2]);
+    hints.icon_pixmap = (*values)[3];
+    hints.icon_window = (*values)[4];
+    hints.icon_x = static_cast<std::int32_t>((*values)[5]);
+    hints.icon_y = static_cast<std::int32_t>((*values)[6]);
+    hints.icon_mask = (*values)[7];
+    hints.window_group = values->size() >= hints_elements
+        ? (*values)[8]
+        : 0;
+
+    return get_hints_from_wmhints(hints);
+}
+
+std::optional<winsys::SizeHints>
+XCBConnection::get_icccm_window_size_hints(winsys::Window window, std::optional<winsys::Dim> min_window_dim)
+{
+    static constexpr std::size_t old_size_elements = 15;
+    static constexpr std::size_t size_elements = 18;
+
+    std::optional<std::vector<std::uint32_t>> values
+        = get_cardlist(window, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS);
+
+    if (!values || values->size() < old_size_elements)
+        return std::nullopt;
+
+    auto value = [&values](std::size_t i) -> int {
+        return static_cast<std::int32_t>((*values)[i]);
+    };
+
+    XSizeHints sh;
+    std::memset(&sh, 0, sizeof(sh));
+
+    sh.flags = (*values)[0] & (USPosition | USSize | PAllHints);
+    sh.x = value(1);
+    sh.y = value(2);
+    sh.width = value(3);
+    sh.height = value(4);
+    sh.min_width = value(5);
+    sh.min_height = value(6);
+    sh.max_width = value(7);
+    sh.max_height = value(8);
+    sh.width_inc = value(9);
+    sh.height_inc = value(10);
+    sh.min_aspect.x = value(11);
+    sh.min_aspect.y = value(12);
+    sh.max_aspect.x = value(13);
+    sh.max_aspect.y = value(14);
+
+    if (values->size() >= size_elements) {
+        sh.flags |= (*values)[0] & (PBaseSize | PWinGravity);
+        sh.base_width = value(15);
+        sh.base_height = value(16);
+        sh.win_gravity = value(17);
+    }
+
+    return get_size_hints_from_sizehints(sh, min_window_dim);
+}
+
+
+// EWMH
+void
+XCBConnection::set_window_desktop(winsys::Window window, Index index)
+{
+    discard_window(window);
+    XConnection::set_window_desktop(window, index);
+}
+
+void
+XCBConnection::set_window_state(winsys::Window window, winsys::WindowState state, bool on)
+{
+    discard_window(window);
+    XConnection::set_window_state(window, state, on);
+}
+
+void
+XCBConnection::set_window_frame_extents(winsys::Window window, winsys::Extents extents)
+{
+    discard_window(window);
+    XConnection::set_window_frame_extents(window, extents);
+}
+
+std::optional<std::vector<std::optional<winsys::Strut>>>
+XCBConnection::get_window_strut(winsys::Window window)
+{
+    std::optional<std::vector<std::optional<winsys::Strut>>> struts_partial
+        = get_window_strut_partial(window);
+
+    if (struts_partial)
+        return struts_partial;
+
+    return get_struts(window, get_netwm_atom(NetWMID::NetWMStrut));
+}
+
+std::optional<std::vector<std::optional<winsys::Strut>>>
+XCBConnection::get_window_strut_partial(winsys::Window window)
+{
+    return get_struts(window, get_netwm_atom(NetWMID::NetWMStrutPartial));
+}
+
+std::optional<Index>
+XCBConnection::get_window_desktop(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> values
+        = get_cardlist(window, get_netwm_atom(NetWMID::NetWMDesktop), XA_CARDINAL);
+
+    if (!values || values->empty())
+        return std::nullopt;
+
+    return (*values)[0];
+}
+
+winsys::EnumSet<winsys::WindowType>
+XCBConnection::get_window_types(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> window_type_atoms
+        = get_cardlist(window, get_netwm_atom(NetWMID::NetWMWindowType), XA_ATOM);
+
+    if (!window_type_atoms)
+        return {};
+
+    winsys::EnumSet<winsys::WindowType> window_types{};
+
+    for (Atom atom : *window_type_atoms)
+        window_types.insert(get_window_type_from_atom(atom));
+
+    return window_types;
+}
+
+winsys::EnumSet<winsys::WindowState>
+XCBConnection::get_window_states(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> window_state_atoms
+        = get_cardlist(window, get_netwm_atom(NetWMID::NetWMState), XA_ATOM);
+
+    if (!window_state_atoms)
+        return {};
+
+    winsys::EnumSet<winsys::WindowState> window_states{};
+
+    for (Atom atom : *window_state_atoms)
+        window_states.insert(get_window_state_from_atom(atom));
+
+    return window_states;
+}
+
+bool
+XCBConnection::window_is_fullscreen(winsys::Window window)
+{
+    return window_has_state(window, winsys::WindowState::Fullscreen);
+}
+
+bool
+XCBConnection::window_is_above(winsys::Window window)
+{
+    return window_has_state(window, winsys::WindowState::Above_);
+}
+
+bool
+XCBConnection::window_is_below(winsys::Window window)
+{
+    return window_has_state(window, winsys::WindowState::Below_);
+}
+
+bool
+XCBConnection::window_is_sticky(winsys::Window window)
+{
+    return window_has_state(window, winsys::WindowState::Sticky);
+}
+
+
+void
+XCBConnection::prefetch_window(winsys::Window window)
+{
+    const Atom properties[] = {
+        get_netwm_atom(NetWMID::NetWMName),
+        XA_WM_NAME,
+        XA_WM_CLASS,
+        XA_WM_HINTS,
+        XA_WM_NORMAL_HINTS,
+        XA_WM_TRANSIENT_FOR,
+        get_netwm_atom(NetWMID::WMClientLeader),
+        get_netwm_atom(NetWMID::NetWMWindowType),
+        get_netwm_atom(NetWMID::NetWMState),
+        get_netwm_atom(NetWMID::NetWMDesktop),
+        get_netwm_atom(NetWMID::NetWMStrutPartial),
+        get_netwm_atom(NetWMID::NetWMStrut),
+        get_netwm_atom(NetWMID::WMProtocols),
+        get_netwm_atom(NetWMID::NetWMSyncRequestCounter),
+    };
+
+    request_attributes(window);
+    request_geometry(window);
+
+    for (Atom atom : properties)
+        request_property(window, atom);
+}
+
+void
+XCBConnection::discard_window(winsys::Window window)
+{
+    std::erase_if(m_property_requests, [this,window](auto& entry) -> bool {
+        if (property_key_window(entry.first) != window)
+            return false;
+
+        if (!entry.second.received)
+            xcb_discard_reply(mp_conn, entry.second.cookie.sequence);
+        else
+            std::free(entry.second.reply);
+
+        return true;
+    });
+
+    auto geometry = m_geometry_requests.find(window);
+    if (geometry != m_geometry_requests.end()) {
+        if (!geometry->second.received)
+            xcb_discard_reply(mp_conn, geometry->second.cookie.sequence);
+        else
+            std::free(geometry->second.reply);
+
+        m_geometry_requests.erase(geometry);
+    }
+
+    auto attributes = m_attributes_requests.find(window);
+    if (attributes != m_attributes_requests.end()) {
+        if (!attributes->second.received)
+            xcb_discard_reply(mp_conn, attributes->second.cookie.sequence);
+        else
+            std::free(attributes->second.reply);
+
+        m_attributes_requests.erase(attributes);
+    }
+
+    auto counter = m_counter_requests.find(window);
+    if (counter != m_counter_requests.end()) {
+        if (!counter->second.received)
+            xcb_discard_reply(mp_conn, counter->second.cookie.sequence);
+        else
+            std::free(counter->second.reply);
+
+        m_counter_requests.erase(counter);
+    }
+}
+
+void
+XCBConnection::discard_requests()
+{
+    for (auto& [_,request] : m_property_requests)
+        if (!request.received)
+            xcb_discard_reply(mp_conn, request.cookie.sequence);
+        else
+            std::free(request.reply);
+
+    for (auto& [_,request] : m_geometry_requests)
+        if (!request.received)
+            xcb_discard_reply(mp_conn, request.cookie.sequence);
+        else
+            std::free(request.reply);
+
+    for (auto& [_,request] : m_attributes_requests)
+        if (!request.received)
+            xcb_discard_reply(mp_conn, request.cookie.sequence);
+        else
+            std::free(request.reply);
+
+    for (auto& [_,request] : m_counter_requests)
+        if (!request.received)
+            xcb_discard_reply(mp_conn, request.cookie.sequence);
+        else
+            std::free(request.reply);
+
+    m_property_requests.clear();
+    m_geometry_requests.clear();
+    m_attributes_requests.clear();
+    m_counter_requests.clear();
+}
+
+void
+XCBConnection::request_property(winsys::Window window, Atom atom)
+{
+    std::uint64_t key = property_key(window, atom);
+
+    if (m_property_requests.count(key) > 0)
+        return;
+
+    m_property_requests[key] = PropertyRequest {
+        xcb_get_property(
+            mp_conn,
+            0,
+            window,
+            atom,
+            XCB_GET_PROPERTY_TYPE_ANY,
+            0,
+            PROPERTY_LENGTH
+        ),
+        nullptr,
+        false
+    };
+}
+
+void
+XCBConnection::request_geometry(winsys::Window window)
+{
+    if (m_geometry_requests.count(window) > 0)
+        return;
+
+    m_geometry_requests[window] = GeometryRequest {
+        xcb_get_geometry(mp_conn, window),
+        nullptr,
+        false
+    };
+}
+
+void
+XCBConnection::request_attributes(winsys::Window window)
+{
+    if (m_attributes_requests.count(window) > 0)
+        return;
+
+    m_attributes_requests[window] = AttributesRequest {
+        xcb_get_window_attributes(mp_conn, window),
+        nullptr,
+        false
+    };
+}
+
+void
+XCBConnection::request_counter(winsys::Window window)
+{
+    if (m_counter_requests.count(window) > 0)
+        return;
+
+    std::optional<XSyncCounter> counter = get_sync_counter(window);
+
+    if (!counter)
+        return;
+
+    m_counter_requests[window] = CounterRequest {
+        xcb_sync_query_counter(mp_conn, *counter),
+        nullptr,
+        false
+    };
+}
+
+xcb_get_property_reply_t*
+XCBConnection::property_reply(winsys::Window window, Atom atom)
+{
+    request_property(window, atom);
+    PropertyRequest& request = m_property_requests.at(property_key(window, atom));
+
+    if (!request.received) {
+        report_round_trip("GetProperty");
+
+        xcb_generic_error_t* error = nullptr;
+        request.reply = xcb_get_property_reply(mp_conn, request.cookie, &error);
+        request.received = true;
+        std::free(error);
+    }
+
+    return request.reply;
+}
+
+xcb_get_geometry_reply_t*
+XCBConnection::geometry_reply(winsys::Window window)
+{
+    request_geometry(window);
+    GeometryRequest& request = m_geometry_requests.at(window);
+
+    if (!request.received) {
+        report_round_trip("GetGeometry");
+
+        xcb_generic_error_t* error = nullptr;
+        request.reply = xcb_get_geometry_reply(mp_conn, request.cookie, &error);
+        request.received = true;
+        std::free(error);
+    }
+
+    return request.reply;
+}
+
+xcb_get_window_attributes_reply_t*
+XCBConnection::attributes_reply(winsys::Window window)
+{
+    request_attributes(window);
+    AttributesRequest& request = m_attributes_requests.at(window);
+
+    if (!request.received) {
+        report_round_trip("GetWindowAttributes");
+
+        xcb_generic_error_t* error = nullptr;
+        request.reply = xcb_get_window_attributes_reply(mp_conn, request.cookie, &error);
+        request.received = true;
+        std::free(error);
+    }
+
+    return request.reply;
+}
+
+xcb_sync_query_counter_reply_t*
+XCBConnection::counter_reply(winsys::Window window)
+{
+    request_counter(window);
+    auto request = m_counter_requests.find(window);
+
+    if (request == m_counter_requests.end())
+        return nullptr;
+
+    if (!request->second.received) {
+        report_round_trip("SyncQueryCounter");
+
+        xcb_generic_error_t* error = nullptr;
+        request->second.reply
+            = xcb_sync_query_counter_reply(mp_conn, request->second.cookie, &error);
+        request->second.received = true;
+        std::free(error);
+    }
+
+    return request->second.reply;
+}
+
+std::optional<XSyncCounter>
+XCBConnection::get_sync_counter(winsys::Window window)
+{
+    std::optional<std::vector<std::uint32_t>> protocols
+        = get_cardlist(window, get_netwm_atom(NetWMID::WMProtocols), XA_ATOM);
+
+    if (!protocols || !Util::contains(*protocols, get_netwm_atom(NetWMID::NetWMSyncRequest)))
+        return std::nullopt;
+
+    std::optional<std::vector<std::uint32_t>> counter
+        = get_cardlist(window, get_netwm_atom(NetWMID::NetWMSyncRequestCounter), XA_CARDINAL);
+
+    if (!counter || counter->empty() || (*counter)[0] == None)
+        return std::nullopt;
+
+    return (*counter)[0];
+}
+
+std::optional<std::vector<std::uint32_t>>
+XCBConnection::get_cardlist(winsys::Window window, Atom atom, Atom type)
+{
+    xcb_get_property_reply_t* reply = property_reply(window, atom);
+
+    if (!reply || reply->type != type || reply->format != 32)
+        return std::nullopt;
+
+    std::uint32_t* values
+        = static_cast<std::uint32_t*>(xcb_get_property_value(reply));
+
+    std::size_t n = xcb_get_property_value_length(reply) / sizeof(std::uint32_t);
+
+    return std::vector<std::uint32_t>(values, values + n);
+}
+
+std::optional<std::string>
+XCBConnection::get_text(winsys::Window window, Atom atom)
+{
+    xcb_get_property_reply_t* reply = property_reply(window, atom);
+
+    if (!reply || reply->type == None || reply->value_len == 0)
+        return std::nullopt;
+
+    char* value = static_cast<char*>(xcb_get_property_value(reply));
+    int length = xcb_get_property_value_length(reply);
+
+    if (reply->type == XA_STRING)
+        return std::string(value, strnlen(value, length));
+
+    XTextProperty text_property;
+    text_property.value = reinterpret_cast<unsigned char*>(value);
+    text_property.encoding = reply->type;
+    text_property.format = reply->format;
+    text_property.nitems = reply->value_len;
+
+    char** list = nullptr;
+    int n = 0;
+    std::string text;
+
+    if (XmbTextPropertyToTextList(mp_dpy, &text_property, &list, &n) >= Success
+        && n > 0 && *list)
+    {
+        text.assign(*list);
+        XFreeStringList(list);
+    }
+
+    return text;
+}
+
+std::optional<std::pair<std::string, std::string>>
+XCBConnection::get_class_hint(winsys::Window window)
+{
+    xcb_get_property_reply_t* reply = property_reply(window, XA_WM_CLASS);
+
+    if (!reply || reply->type != XA_STRING || reply->format != 8)
+        return std::nullopt;
+
+    char* value = static_cast<char*>(xcb_get_property_value(reply));
+    std::size_t length = xcb_get_property_value_length(reply);
+
+    std::size_t instance_length = strnlen(value, length);
+    std::string instance(value, instance_length);
+    std::string class_;
+
+    if (instance_length + 1 < length)
+        class_.assign(
+            value + instance_length + 1,
+            strnlen(value + instance_length + 1, length - instance_length - 1)
+        );
+
+    return std::pair{ instance, class_ };
+}
+
+std::optional<std::vector<std::optional<winsys::Strut>>>
+XCBConnection::get_struts(winsys::Window window, Atom atom)
+{
+    std::optional<std::vector<std::uint32_t>> strut_widths
+        = get_cardlist(window, atom, XA_CARDINAL);
+
+    if (!strut_widths || strut_widths->empty())
+        return std::nullopt;
+
+    std::vector<std::optional<winsys::Strut>> struts;
+    struts.reserve(4);
+
+    for (std::size_t i = 0; i < strut_widths->size() && i < 4; ++i) {
+        std::optional<winsys::Strut> strut = std::nullopt;
+
+        if ((*strut_widths)[i] > 0)
+            strut = winsys::Strut {
+                window,
+                static_cast<int>((*strut_widths)[i])
+            };
+
+        struts.push_back(strut);
+    }
+
+    return struts;
+}
+
+bool
+XCBConnection::window_has_state(winsys::Window window, winsys::WindowState state)
+{
+    return get_window_states(window).count(state) > 0;
+}
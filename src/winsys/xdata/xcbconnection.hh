@@ -0,0 +1,116 @@
+#ifndef __WINSYS_XDATA_XCBCONNECTION_H_GUARD__
+#define __WINSYS_XDATA_XCBCONNECTION_H_GUARD__
+
+#include "xconnection.hh"
+
+#include <cstdint>
+#include <unordered_map>
+
+extern "C" {
+#include <xcb/sync.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+}
+
+// Shares the Xlib display (and thereby its event queue) with XConnection, but
+// issues all window queries through xcb. Requests for a window are sent up
+// front as cookies and their replies are only collected once they are needed,
+// so that the queries performed while handling a single event cost a single
+// round trip.
+class XCBConnection final: public XConnection
+{
+public:
+    XCBConnection(const std::string_view);
+    ~XCBConnection();
+
+    virtual winsys::Event step() override;
+    virtual void process_messages(std::function<void(winsys::Message)> const&) override;
+    virtual void cleanup() override;
+
+    // window manipulation
+    virtual bool init_sync_request(winsys::Window) override;
+    virtual void cleanup_window(winsys::Window) override;
+    virtual std::optional<winsys::Region> get_window_geometry(winsys::Window) override;
+    virtual bool must_manage_window(winsys::Window) override;
+    virtual bool must_free_window(winsys::Window) override;
+    virtual bool window_is_mappable(winsys::Window) override;
+    virtual winsys::WindowSnapshot fetch_window_snapshot(winsys::Window) override;
+    virtual std::vector<winsys::WindowSnapshot> fetch_window_snapshots(std::vector<winsys::Window> const&) override;
+
+    // ICCCM
+    virtual void set_icccm_window_state(winsys::Window, winsys::IcccmWindowState) override;
+    virtual void set_icccm_window_hints(winsys::Window, winsys::Hints) override;
+    virtual std::string get_icccm_window_name(winsys::Window) override;
+    virtual std::string get_icccm_window_class(winsys::Window) override;
+    virtual std::string get_icccm_window_instance(winsys::Window) override;
+    virtual std::optional<winsys::Window> get_icccm_window_transient_for(winsys::Window) override;
+    virtual std::optional<winsys::Window> get_icccm_window_client_leader(winsys::Window) override;
+    virtual std::optional<winsys::Hints> get_icccm_window_hints(winsys::Window) override;
+    virtual std::optional<winsys::SizeHints> get_icccm_window_size_hints(winsys::Window, std::optional<winsys::Dim>) override;
+
+    // EWMH
+    virtual void set_window_desktop(winsys::Window, Index) override;
+    virtual void set_window_state(winsys::Window, winsys::WindowState, bool) override;
+    virtual void set_window_frame_extents(winsys::Window, winsys::Extents) override;
+    virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut(winsys::Window) override;
+    virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut_partial(winsys::Window) override;
+    virtual std::optional<Index> get_window_desktop(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowType> get_window_types(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowState> get_window_states(winsys::Window) override;
+    virtual bool window_is_fullscreen(winsys::Window) override;
+    virtual bool window_is_above(winsys::Window) override;
+    virtual bool window_is_below(winsys::Window) override;
+    virtual bool window_is_sticky(winsys::Window) override;
+
+private:
+    static constexpr std::uint32_t PROPERTY_LENGTH = 1024;
+
+    template <typename Cookie, typename Reply>
+    struct Request final
+    {
+        Cookie cookie;
+        Reply* reply;
+        bool received;
+    };
+
+    typedef Request<xcb_get_property_cookie_t, xcb_get_property_reply_t>
+        PropertyRequest;
+    typedef Request<xcb_get_geometry_cookie_t, xcb_get_geometry_reply_t>
+        GeometryRequest;
+    typedef Request<xcb_get_window_attributes_cookie_t, xcb_get_window_attributes_reply_t>
+        AttributesRequest;
+    typedef Request<xcb_sync_query_counter_cookie_t, xcb_sync_query_counter_reply_t>
+        CounterRequest;
+
+    xcb_connection_t* mp_conn;
+
+    std::unordered_map<std::uint64_t, PropertyRequest> m_property_requests;
+    std::unordered_map<winsys::Window, GeometryRequest> m_geometry_requests;
+    std::unordered_map<winsys::Window, AttributesRequest> m_attributes_requests;
+    std::unordered_map<winsys::Window, CounterRequest> m_counter_requests;
+
+    void prefetch_window(winsys::Window);
+    void discard_window(winsys::Window);
+    void discard_requests();
+
+    void request_property(winsys::Window, Atom);
+    void request_geometry(winsys::Window);
+    void request_attributes(winsys::Window);
+    void request_counter(winsys::Window);
+
+    xcb_get_property_reply_t* property_reply(winsys::Window, Atom);
+    xcb_get_geometry_reply_t* geometry_reply(winsys::Window);
+    xcb_get_window_attributes_reply_t* attributes_reply(winsys::Window);
+    xcb_sync_query_counter_reply_t* counter_reply(winsys::Window);
+
+    std::optional<XSyncCounter> get_sync_counter(winsys::Window);
+
+    std::optional<std::vector<std::uint32_t>> get_cardlist(winsys::Window, Atom, Atom);
+    std::optional<std::string> get_text(winsys::Window, Atom);
+    std::optional<std::pair<std::string, std::string>> get_class_hint(winsys::Window);
+    std::optional<std::vector<std::optional<winsys::Strut>>> get_struts(winsys::Window, Atom);
+
+    bool window_has_state(winsys::Window, winsys::WindowState);
+};
+
+#endif//__WINSYS_XDATA_XCBCONNECTION_H_GUARD__
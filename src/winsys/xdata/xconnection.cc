@@ -3,6 +3,7 @@
 #include "xconnection.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iomanip>
 #include <iterator>
@@ -10,18 +11,26 @@
 #include <sstream>
 #include <deque>
 
+#ifdef DEBUG
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+#endif
+
+#include "spdlog/spdlog.h"
+
 extern "C" {
 #include <X11/XF86keysym.h>
 #include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
 #include <X11/Xproto.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/XRes.h>
 #include <X11/extensions/Xinerama.h>
+#include <X11/extensions/Xrandr.h>
 #include <X11/keysym.h>
 #include <X11/keysymdef.h>
 #include <fcntl.h>
-#include <proc/readproc.h>
 #include <signal.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <xcb/xcb.h>
@@ -47,15 +56,20 @@ XConnection::XConnection(const std::string_view wm_name)
       m_dpy_fd(XConnectionNumber(mp_dpy)),
       m_sock_fd(-1),
       m_client_fd(-1),
-      m_max_fd(-1),
+      m_epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+      m_dpy_ready(false),
+      m_sock_ready(false),
+      m_fd_watchers({}),
       m_wm_name(wm_name),
-      m_interned_atoms({}),
-      m_atom_names({}),
+      m_keyboard_mapping({}),
+      m_min_keycode(0),
+      m_keysyms_per_keycode(0),
       m_keys({}),
       m_keycodes({}),
+      m_key_grabs({}),
       m_netwm_atoms({})
 {
-    static const std::unordered_map<NetWMID, const char*> NETWM_ATOM_NAMES({
+    static const std::unordered_map<NetWMID, const char*> ATOM_NAMES({
         { NetWMID::NetSupported,                "_NET_SUPPORTED"                    },
         { NetWMID::NetClientList,               "_NET_CLIENT_LIST"                  },
         { NetWMID::NetNumberOfDesktops,         "_NET_NUMBER_OF_DESKTOPS"           },
@@ -69,10 +83,12 @@ XConnection::XConnection(const std::string_view wm_name)
         { NetWMID::NetWMDesktop,                "_NET_WM_DESKTOP"                   },
         { NetWMID::NetWMStrut,                  "_NET_WM_STRUT"                     },
         { NetWMID::NetWMStrutPartial,           "_NET_WM_STRUT_PARTIAL"             },
-        { NetWMID::NetWMFrameExtents,           "_NET_WM_FRAME_EXTENTS"             },
+        { NetWMID::NetWMFrameExtents,           "_NET_FRAME_EXTENTS"                },
         { NetWMID::NetSupportingWMCheck,        "_NET_SUPPORTING_WM_CHECK"          },
         { NetWMID::NetWMState,                  "_NET_WM_STATE"                     },
         { NetWMID::NetWMWindowType,             "_NET_WM_WINDOW_TYPE"               },
+        { NetWMID::NetWMSyncRequest,            "_NET_WM_SYNC_REQUEST"              },
+        { NetWMID::NetWMSyncRequestCounter,     "_NET_WM_SYNC_REQUEST_COUNTER"      },
         // root messages
         { NetWMID::NetWMCloseWindow,            "_NET_CLOSE_WINDOW"                 },
         { NetWMID::NetWMMoveResize,             "_NET_WM_MOVERESIZE"                },
@@ -97,10 +113,45 @@ XConnection::XConnection(const std::string_view wm_name)
         { NetWMID::NetWMWindowTypeTooltip,      "_NET_WM_WINDOW_TYPE_TOOLTIP"       },
         { NetWMID::NetWMWindowTypeNotification, "_NET_WM_WINDOW_TYPE_NOTIFICATION"  },
         { NetWMID::NetWMWindowTypeNormal,       "_NET_WM_WINDOW_TYPE_NORMAL"        },
+        // in use, but not advertised as supported
+        { NetWMID::NetClientListStacking,       "_NET_CLIENT_LIST_STACKING"         },
+        { NetWMID::NetWMPid,                    "_NET_WM_PID"                       },
+        { NetWMID::NetWMStateModal,             "_NET_WM_STATE_MODAL"               },
+        { NetWMID::NetWMStateSticky,            "_NET_WM_STATE_STICKY"              },
+        { NetWMID::NetWMStateMaximizedVert,     "_NET_WM_STATE_MAXIMIZED_VERT"      },
+        { NetWMID::NetWMStateMaximizedHorz,     "_NET_WM_STATE_MAXIMIZED_HORZ"      },
+        { NetWMID::NetWMStateShaded,            "_NET_WM_STATE_SHADED"              },
+        { NetWMID::NetWMStateSkipTaskbar,       "_NET_WM_STATE_SKIP_TASKBAR"        },
+        { NetWMID::NetWMStateSkipPager,         "_NET_WM_STATE_SKIP_PAGER"          },
+        { NetWMID::NetWMWindowTypeCombo,        "_NET_WM_WINDOW_TYPE_COMBO"         },
+        { NetWMID::NetWMWindowTypeDnd,          "_NET_WM_WINDOW_TYPE_DND"           },
+        // ICCCM
+        { NetWMID::WMName,                      "WM_NAME"                           },
+        { NetWMID::WMClass,                     "WM_CLASS"                          },
+        { NetWMID::WMState,                     "WM_STATE"                          },
+        { NetWMID::WMProtocols,                 "WM_PROTOCOLS"                      },
+        { NetWMID::WMDeleteWindow,              "WM_DELETE_WINDOW"                  },
+        { NetWMID::WMClientLeader,              "WM_CLIENT_LEADER"                  },
+        { NetWMID::Utf8String,                  "UTF8_STRING"                       },
     });
 
-    for (auto&& [id,name] : NETWM_ATOM_NAMES)
-        m_netwm_atoms[id] = get_atom(name);
+    // every atom is interned in a single round trip
+    char* atom_names[NetWMID::AtomLast];
+    for (auto&& [id,name] : ATOM_NAMES)
+        atom_names[id] = const_cast<char*>(name);
+
+    report_round_trip("InternAtoms");
+    if (!XInternAtoms(mp_dpy, atom_names, NetWMID::AtomLast, False, m_netwm_atoms.data()))
+        Util::die("unable to intern atoms");
+
+    load_keyboard_mapping();
+
+    int sync_error_base, sync_major, sync_minor;
+    m_sync_available = XSyncQueryExtension(mp_dpy, &m_sync_event_base, &sync_error_base)
+        && XSyncInitialize(mp_dpy, &sync_major, &sync_minor);
+
+    int randr_error_base;
+    m_randr_available = XRRQueryExtension(mp_dpy, &m_randr_event_base, &randr_error_base);
 
     for (std::size_t i = 0; i < LASTEvent; ++i)
         m_event_dispatcher[i] = &XConnection::on_unimplemented;
@@ -122,10 +173,29 @@ XConnection::XConnection(const std::string_view wm_name)
     m_event_dispatcher[MotionNotify] = &XConnection::on_motion_notify;
     m_event_dispatcher[PropertyNotify] = &XConnection::on_property_notify;
     m_event_dispatcher[UnmapNotify] = &XConnection::on_unmap_notify;
+
+    XVisualInfo vinfo;
+    if (XMatchVisualInfo(mp_dpy, DefaultScreen(mp_dpy), 32, TrueColor, &vinfo)) {
+        mp_frame_visual = vinfo.visual;
+        m_frame_depth = vinfo.depth;
+        m_frame_colormap = XCreateColormap(mp_dpy, m_root, vinfo.visual, AllocNone);
+    }
+
+    if (m_epoll_fd == -1)
+        Util::die("unable to set up event loop");
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = m_dpy_fd;
+
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_dpy_fd, &event) == -1)
+        Util::die("unable to watch display connection");
 }
 
 XConnection::~XConnection()
-{}
+{
+    close(m_epoll_fd);
+}
 
 
 void
@@ -200,12 +270,20 @@ XConnection::init_wm_ipc()
         Util::die("unable to listen to IPC socket");
 
     fcntl(m_sock_fd, F_SETFD, FD_CLOEXEC | fcntl(m_sock_fd, F_GETFD));
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = m_sock_fd;
+
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_sock_fd, &event) == -1)
+        Util::die("unable to watch IPC socket");
 }
 
 
 bool
 XConnection::flush()
 {
+    fence_crossing_requests();
     XFlush(mp_dpy);
     return true;
 }
@@ -214,8 +292,15 @@ winsys::Event
 XConnection::step()
 {
     next_event(m_current_event);
+    update_shadows(m_current_event);
+
+    if (m_sync_available && m_current_event.type == m_sync_event_base + XSyncAlarmNotify)
+        return on_sync_alarm();
 
-    if (m_current_event.type >= 0 && m_current_event.type <= 256)
+    if (m_randr_available && m_current_event.type == m_randr_event_base + RRScreenChangeNotify)
+        return on_screen_change();
+
+    if (m_current_event.type >= 0 && m_current_event.type < LASTEvent)
         return (this->*(m_event_dispatcher[m_current_event.type]))();
 
     return std::monostate{};
@@ -224,27 +309,58 @@ XConnection::step()
 bool
 XConnection::check_progress()
 {
+    static constexpr int MAX_EVENTS = 16;
+    static struct epoll_event events[MAX_EVENTS];
+
+    fence_crossing_requests();
     XFlush(mp_dpy);
 
-    FD_ZERO(&m_descr);
-    FD_SET(m_sock_fd, &m_descr);
-    FD_SET(m_dpy_fd, &m_descr);
-    m_max_fd = std::max(m_sock_fd, m_dpy_fd);
+    // events that Xlib has already read off the socket do not wake epoll,
+    // nor do those deferred to a later iteration
+    m_dpy_ready = !m_event_batch.empty() || XEventsQueued(mp_dpy, QueuedAlready) > 0;
+    m_sock_ready = false;
+
+    int n = epoll_wait(m_epoll_fd, events, MAX_EVENTS, m_dpy_ready ? 0 : -1);
+
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+
+        if (fd == m_dpy_fd)
+            m_dpy_ready = true;
+        else if (fd == m_sock_fd)
+            m_sock_ready = true;
+        else if (m_fd_watchers.count(fd) > 0) {
+            std::function<void()> callback = m_fd_watchers.at(fd);
+            callback();
+        }
+    }
 
-    return select(m_max_fd + 1, &m_descr, NULL, NULL, NULL) > 0;
+    return m_dpy_ready || m_sock_ready;
 }
 
 void
-XConnection::process_events(std::function<void(winsys::Event)> callback)
+XConnection::process_events(std::function<void(winsys::Event)> const& callback)
 {
-    if (FD_ISSET(m_dpy_fd, &m_descr))
-        while (XPending(mp_dpy))
-            callback(step());
+    if (!m_dpy_ready)
+        return;
+
+    read_event_batch();
+
+    dispatch_events(callback, EventClass::Input, m_event_batch.size());
+    dispatch_events(callback, EventClass::Structural, STRUCTURAL_QUANTUM);
+    dispatch_events(callback, EventClass::Background, BACKGROUND_QUANTUM);
+
+    Util::erase_remove_if(m_event_batch, [](XEvent const& event) {
+        return event.type == SPENT_EVENT;
+    });
 }
 
 void
-XConnection::process_messages(std::function<void(winsys::Message)> callback)
+XConnection::process_messages(std::function<void(winsys::Message)> const& callback)
 {
+    if (!m_confined_to)
+        m_pointer_shadow = std::nullopt;
+
     enum MessageType {
         Command,
         Config,
@@ -270,7 +386,7 @@ XConnection::process_messages(std::function<void(winsys::Message)> callback)
     static int n = 0;
     static char msg[BUFSIZ] = {};
 
-    if (FD_ISSET(m_sock_fd, &m_descr)) {
+    if (m_sock_ready) {
         m_client_fd = accept(m_sock_fd, NULL, 0);
 
         if (m_client_fd > 0 && (n = recv(m_client_fd, msg, sizeof(msg) - 1, 0)) > 0) {
@@ -294,16 +410,16 @@ XConnection::process_messages(std::function<void(winsys::Message)> callback)
                         words.pop_front();
 
                         switch (message_types.at(area)) {
-                        case Command:   message = winsys::CommandMessage{words};   break;
-                        case Config:    message = winsys::ConfigMessage{words};    break;
-                        case Window:    message = winsys::WindowMessage{words};    break;
-                        case Workspace: message = winsys::WorkspaceMessage{words}; break;
-                        case Query:     message = winsys::QueryMessage{words};     break;
+                        case Command:   message = winsys::CommandMessage{std::move(words)};   break;
+                        case Config:    message = winsys::ConfigMessage{std::move(words)};    break;
+                        case Window:    message = winsys::WindowMessage{std::move(words)};    break;
+                        case Workspace: message = winsys::WorkspaceMessage{std::move(words)}; break;
+                        case Query:     message = winsys::QueryMessage{std::move(words)};     break;
                         }
                     }
                 }
 
-                callback(message);
+                callback(std::move(message));
             } else
                 close(m_client_fd);
         }
@@ -314,6 +430,8 @@ std::vector<winsys::Screen>
 XConnection::connected_outputs()
 {
     int n_screen_info;
+
+    report_round_trip("XineramaQueryScreens");
     XineramaScreenInfo* screen_info = XineramaQueryScreens(mp_dpy, &n_screen_info);
     std::vector<XineramaScreenInfo*> screen_info_vector;
 
@@ -378,6 +496,43 @@ XConnection::connected_outputs()
     return screens;
 }
 
+unsigned
+XConnection::get_refresh_rate()
+{
+    report_round_trip("RRGetScreenResourcesCurrent");
+    XRRScreenResources* resources = XRRGetScreenResourcesCurrent(mp_dpy, m_root);
+
+    if (!resources)
+        return 0;
+
+    double refresh_rate = 0.0;
+
+    // the fastest of the active outputs sets the pace
+    for (int i = 0; i < resources->ncrtc; ++i) {
+        report_round_trip("RRGetCrtcInfo");
+        XRRCrtcInfo* crtc = XRRGetCrtcInfo(mp_dpy, resources, resources->crtcs[i]);
+
+        if (!crtc)
+            continue;
+
+        for (int j = 0; crtc->mode != None && j < resources->nmode; ++j) {
+            XRRModeInfo const& mode = resources->modes[j];
+
+            if (mode.id == crtc->mode && mode.hTotal > 0 && mode.vTotal > 0)
+                refresh_rate = std::max(
+                    refresh_rate,
+                    static_cast<double>(mode.dotClock)
+                        / (static_cast<double>(mode.hTotal) * static_cast<double>(mode.vTotal))
+                );
+        }
+
+        XRRFreeCrtcInfo(crtc);
+    }
+
+    XRRFreeScreenResources(resources);
+    return static_cast<unsigned>(std::lround(refresh_rate));
+}
+
 std::vector<winsys::Window>
 XConnection::top_level_windows()
 {
@@ -385,6 +540,7 @@ XConnection::top_level_windows()
     Window* children;
     unsigned nchildren;
 
+    report_round_trip("QueryTree");
     XQueryTree(mp_dpy, m_root, &_w, &_w, &children, &nchildren);
 
     std::vector<winsys::Window> windows;
@@ -401,6 +557,11 @@ XConnection::top_level_windows()
 winsys::Pos
 XConnection::get_pointer_position()
 {
+    if (m_pointer_shadow)
+        return *m_pointer_shadow;
+
+    report_round_trip("QueryPointer");
+
     winsys::Window _r, _c;
     int rx, ry, _wx, _wy;
     unsigned _m;
@@ -423,15 +584,12 @@ XConnection::warp_pointer_center_of_window_or_root(std::optional<winsys::Window>
     winsys::Pos pos;
 
     if (window) {
-        XWindowAttributes wa;
-        XGetWindowAttributes(mp_dpy, *window, &wa);
+        std::optional<winsys::Region> region = get_window_geometry(*window);
 
-        pos = winsys::Pos::from_center_of_dim(
-            winsys::Dim {
-                wa.width,
-                wa.height
-            }
-        );
+        if (!region)
+            return;
+
+        pos = winsys::Pos::from_center_of_dim(region->dim);
     } else
         pos = winsys::Pos::from_center_of_dim(
             screen.placeable_region().dim
@@ -444,6 +602,8 @@ XConnection::warp_pointer_center_of_window_or_root(std::optional<winsys::Window>
         0, 0, 0, 0,
         pos.x, pos.y
     );
+
+    m_pointer_shadow = std::nullopt;
 }
 
 void
@@ -456,6 +616,8 @@ XConnection::warp_pointer(winsys::Pos pos)
         0, 0, 0, 0,
         pos.x, pos.y
     );
+
+    m_pointer_shadow = pos;
 }
 
 void
@@ -468,12 +630,16 @@ XConnection::warp_pointer_rpos(winsys::Window window, winsys::Pos pos)
         0, 0, 0, 0,
         pos.x, pos.y
     );
+
+    m_pointer_shadow = std::nullopt;
 }
 
 void
 XConnection::confine_pointer(winsys::Window window)
 {
     if (!m_confined_to) {
+        report_round_trip("GrabPointer");
+
         int status = XGrabPointer(
             mp_dpy,
             m_root,
@@ -514,32 +680,62 @@ XConnection::release_pointer()
 }
 
 void
-XConnection::call_external_command(std::string& command)
+XConnection::watch_fd(int fd, std::function<void()> callback)
 {
-    if (!fork()) {
-        if (mp_dpy)
-            close(m_dpy_fd);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
 
-        setsid();
-        execl("/bin/sh", "/bin/sh", "-c", ("exec " + command).c_str(), NULL);
-        exit(EXIT_SUCCESS);
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        spdlog::warn("unable to watch file descriptor {}", fd);
+        return;
     }
+
+    m_fd_watchers[fd] = callback;
+}
+
+void
+XConnection::unwatch_fd(int fd)
+{
+    if (m_fd_watchers.erase(fd) > 0)
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
 }
 
 void
 XConnection::cleanup()
 {
+#ifdef DEBUG
+    spdlog::debug(
+        "suppressed requests: {} geometry, {} border width, {} border color, "
+        "{} background color, {} event mask, {} map state, {} offset",
+        m_suppressed_requests.geometry,
+        m_suppressed_requests.border_width,
+        m_suppressed_requests.border_color,
+        m_suppressed_requests.background_color,
+        m_suppressed_requests.event_mask,
+        m_suppressed_requests.map_state,
+        m_suppressed_requests.offset
+    );
+#endif
+
     XUngrabKey(mp_dpy, AnyKey, AnyModifier, m_root);
     XDestroyWindow(mp_dpy, m_check_window);
 
-    unset_card_property(m_root, "_NET_ACTIVE_WINDOW");
-    unset_window_property(m_root, "_NET_SUPPORTING_WM_CHECK");
-    unset_string_property(m_root, "_NET_WM_NAME");
-    unset_string_property(m_root, "WN_CLASS");
-    unset_string_property(m_root, "WN_CLASS");
-    unset_atomlist_property(m_root, "_NET_SUPPORTED");
-    unset_card_property(m_root, "_NET_WM_PID");
-    unset_windowlist_property(m_root, "_NET_CLIENT_LIST");
+    unset_card_property(m_root, NetWMID::NetActiveWindow);
+    unset_window_property(m_root, NetWMID::NetSupportingWMCheck);
+    unset_string_property(m_root, NetWMID::NetWMName);
+    unset_stringlist_property(m_root, NetWMID::WMClass);
+    unset_atomlist_property(m_root, NetWMID::NetSupported);
+    unset_card_property(m_root, NetWMID::NetWMPid);
+    unset_windowlist_property(m_root, NetWMID::NetClientList);
+
+    for (winsys::Window frame : m_frame_pool)
+        XDestroyWindow(mp_dpy, frame);
+
+    m_frame_pool.clear();
+
+    if (m_frame_colormap != None)
+        XFreeColormap(mp_dpy, m_frame_colormap);
 
     XCloseDisplay(mp_dpy);
 }
@@ -549,33 +745,80 @@ XConnection::cleanup()
 winsys::Window
 XConnection::create_frame(winsys::Region region)
 {
+    if (!m_frame_pool.empty()) {
+        winsys::Window frame = m_frame_pool.back();
+        m_frame_pool.pop_back();
+
+        place_window(frame, region);
+        return frame;
+    }
+
     long mask = CWBackPixel | CWBorderPixel;
     XSetWindowAttributes wa;
 
-    XVisualInfo vinfo;
-    if (XMatchVisualInfo(mp_dpy, DefaultScreen(mp_dpy), 32, TrueColor, &vinfo)) {
-        wa.colormap = XCreateColormap(mp_dpy, m_root, vinfo.visual, AllocNone);
+    if (mp_frame_visual) {
+        wa.colormap = m_frame_colormap;
         mask |= CWColormap;
     }
 
     wa.background_pixel = 0;
     wa.border_pixel = 0;
 
-    winsys::Window window = XCreateWindow(
+    winsys::Window frame = XCreateWindow(
         mp_dpy, m_root,
         region.pos.x, region.pos.y,
         region.dim.w, region.dim.h,
         0,
-        vinfo.depth,
+        m_frame_depth,
         InputOutput,
-        vinfo.visual,
+        mp_frame_visual ? mp_frame_visual : CopyFromParent,
         mask,
         &wa
     );
 
-    flush();
+    // a press anywhere in the frame freezes the pointer until it has been
+    // seen, after which it is replayed to the client; the grab is set up once
+    // and outlives focus changes and the frame's stay in the pool
+    XGrabButton(mp_dpy,
+        AnyButton,
+        AnyModifier,
+        frame,
+        True,
+        ButtonPressMask,
+        GrabModeSync,
+        GrabModeAsync,
+        None,
+        None
+    );
 
-    return window;
+    return frame;
+}
+
+void
+XConnection::release_frame(winsys::Window frame)
+{
+    if (m_frame_pool.size() >= FRAME_POOL_SIZE) {
+        destroy_window(frame);
+        return;
+    }
+
+    // an idle frame selects no events, so that its reuse starts afresh with
+    // init_frame
+    XSetWindowAttributes wa;
+    wa.event_mask = NoEventMask;
+
+    XChangeWindowAttributes(mp_dpy, frame, CWEventMask, &wa);
+
+    if (WindowShadow* shadow = get_shadow(frame))
+        shadow->event_mask = wa.event_mask;
+
+    // the root must not report the unmap either: by the time it would be
+    // read, the frame may already belong to another client
+    disable_substructure_events();
+    unmap_window(frame);
+    enable_substructure_events();
+
+    m_frame_pool.push_back(frame);
 }
 
 void
@@ -588,6 +831,87 @@ XConnection::init_window(winsys::Window window)
     wa.event_mask = window_event_mask;
 
     XChangeWindowAttributes(mp_dpy, window, CWEventMask, &wa);
+    track_window(window);
+    get_shadow(window)->event_mask = wa.event_mask;
+}
+
+bool
+XConnection::init_sync_request(winsys::Window window)
+{
+    if (!m_sync_available)
+        return false;
+
+    Atom* protocols;
+    int n = 0;
+
+    Atom sync_atom = get_netwm_atom(NetWMID::NetWMSyncRequest);
+    bool found = false;
+
+    report_round_trip("GetWMProtocols");
+
+    if (XGetWMProtocols(mp_dpy, window, &protocols, &n)) {
+        while (!found && n--)
+            found = sync_atom == protocols[n];
+
+        XFree(protocols);
+    }
+
+    if (!found)
+        return false;
+
+    return init_sync_alarm(
+        window,
+        get_card_property(window, NetWMID::NetWMSyncRequestCounter)
+    );
+}
+
+bool
+XConnection::init_sync_alarm(winsys::Window window, XSyncCounter counter)
+{
+    if (counter == None)
+        return false;
+
+    XSyncValue value;
+
+    report_round_trip("SyncQueryCounter");
+    if (!XSyncQueryCounter(mp_dpy, counter, &value))
+        return false;
+
+    return init_sync_alarm(window, counter, value);
+}
+
+bool
+XConnection::init_sync_alarm(winsys::Window window, XSyncCounter counter, XSyncValue value)
+{
+    // the alarm fires once the counter reaches the value of the latest sync
+    // request, after which it waits for the next one
+    XSyncAlarmAttributes attributes;
+    attributes.trigger.counter = counter;
+    attributes.trigger.value_type = XSyncAbsolute;
+    attributes.trigger.test_type = XSyncPositiveComparison;
+    attributes.trigger.wait_value = value;
+    XSyncIntToValue(&attributes.delta, 1);
+    attributes.events = True;
+
+    XSyncAlarm alarm = XSyncCreateAlarm(
+        mp_dpy,
+        XSyncCACounter | XSyncCAValueType | XSyncCATestType
+            | XSyncCAValue | XSyncCADelta | XSyncCAEvents,
+        &attributes
+    );
+
+    if (alarm == None)
+        return false;
+
+    m_sync_counters[window] = SyncCounter {
+        counter,
+        alarm,
+        (static_cast<std::int64_t>(XSyncValueHigh32(value)) << 32)
+            | XSyncValueLow32(value)
+    };
+
+    m_sync_alarms[alarm] = window;
+    return true;
 }
 
 void
@@ -604,6 +928,8 @@ XConnection::init_frame(winsys::Window window, bool focus_follows_mouse)
         wa.event_mask |= EnterWindowMask;
 
     XChangeWindowAttributes(mp_dpy, window, CWEventMask, &wa);
+    track_window(window);
+    get_shadow(window)->event_mask = wa.event_mask;
 }
 
 void
@@ -615,6 +941,8 @@ XConnection::init_unmanaged(winsys::Window window)
     wa.event_mask = unmanaged_event_mask;
 
     XChangeWindowAttributes(mp_dpy, window, CWEventMask, &wa);
+    track_window(window);
+    get_shadow(window)->event_mask = wa.event_mask;
 }
 
 void
@@ -634,25 +962,60 @@ XConnection::init_resize(winsys::Window)
 void
 XConnection::cleanup_window(winsys::Window window)
 {
-    XDeleteProperty(mp_dpy, window, get_atom("_NET_WM_STATE"));
-    XDeleteProperty(mp_dpy, window, get_atom("_NET_WM_DESKTOP"));
+    XDeleteProperty(mp_dpy, window, get_netwm_atom(NetWMID::NetWMState));
+    XDeleteProperty(mp_dpy, window, get_netwm_atom(NetWMID::NetWMDesktop));
+
+    auto sync = m_sync_counters.find(window);
+
+    if (sync != m_sync_counters.end()) {
+        XSyncDestroyAlarm(mp_dpy, sync->second.alarm);
+        m_sync_alarms.erase(sync->second.alarm);
+        m_sync_counters.erase(sync);
+    }
+
+    untrack_window(window);
 }
 
 void
 XConnection::map_window(winsys::Window window)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->mapped == true) {
+        ++m_suppressed_requests.map_state;
+        return;
+    }
+
+    if (write_shadow(window))
+        shadow->mapped = true;
+
+    note_crossing_request();
     XMapWindow(mp_dpy, window);
 }
 
 void
 XConnection::unmap_window(winsys::Window window)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->mapped == false) {
+        ++m_suppressed_requests.map_state;
+        return;
+    }
+
+    if (write_shadow(window))
+        shadow->mapped = false;
+
+    note_crossing_request();
     XUnmapWindow(mp_dpy, window);
 }
 
 void
 XConnection::reparent_window(winsys::Window window, winsys::Window parent, winsys::Pos pos)
 {
+    if (WindowShadow* shadow = write_shadow(window); shadow && shadow->region)
+        shadow->region->pos = pos;
+
     disable_substructure_events();
     XReparentWindow(mp_dpy, window, parent, pos.x, pos.y);
     enable_substructure_events();
@@ -661,6 +1024,9 @@ XConnection::reparent_window(winsys::Window window, winsys::Window parent, winsy
 void
 XConnection::unparent_window(winsys::Window window, winsys::Pos pos)
 {
+    if (WindowShadow* shadow = write_shadow(window); shadow && shadow->region)
+        shadow->region->pos = pos;
+
     disable_substructure_events();
     XReparentWindow(mp_dpy, window, m_root, pos.x, pos.y);
     enable_substructure_events();
@@ -670,6 +1036,7 @@ void
 XConnection::destroy_window(winsys::Window window)
 {
     XDestroyWindow(mp_dpy, window);
+    untrack_window(window);
 }
 
 bool
@@ -678,9 +1045,11 @@ XConnection::close_window(winsys::Window window)
     Atom* protocols;
     int n = 0;
 
-    Atom delete_atom = get_atom("WM_DELETE_WINDOW");
+    Atom delete_atom = get_netwm_atom(NetWMID::WMDeleteWindow);
     bool found = false;
 
+    report_round_trip("GetWMProtocols");
+
     if (XGetWMProtocols(mp_dpy, window, &protocols, &n)) {
         while (!found && n--)
             found = delete_atom == protocols[n];
@@ -692,9 +1061,9 @@ XConnection::close_window(winsys::Window window)
         XEvent event;
         event.type = ClientMessage;
         event.xclient.window = window;
-        event.xclient.message_type = get_atom("WM_PROTOCOLS");
+        event.xclient.message_type = get_netwm_atom(NetWMID::WMProtocols);
         event.xclient.format = 32;
-        event.xclient.data.l[0] = get_atom("WM_DELETE_WINDOW");
+        event.xclient.data.l[0] = get_netwm_atom(NetWMID::WMDeleteWindow);
         event.xclient.data.l[1] = CurrentTime;
         XSendEvent(mp_dpy, window, False, NoEventMask, &event);
 
@@ -712,6 +1081,7 @@ XConnection::kill_window(winsys::Window window)
         XSetErrorHandler(s_passthrough_error_handler);
         XSetCloseDownMode(mp_dpy, DestroyAll);
         XKillClient(mp_dpy, window);
+        report_round_trip("Sync");
         XSync(mp_dpy, False);
         XSetErrorHandler(s_default_error_handler);
         XUngrabServer(mp_dpy);
@@ -723,7 +1093,18 @@ XConnection::kill_window(winsys::Window window)
 void
 XConnection::place_window(winsys::Window window, winsys::Region& region)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->region == region) {
+        ++m_suppressed_requests.geometry;
+        return;
+    }
+
+    if (write_shadow(window))
+        shadow->region = region;
+
     disable_substructure_events();
+    note_crossing_request();
     XMoveResizeWindow(mp_dpy, window, region.pos.x, region.pos.y, region.dim.w, region.dim.h);
     enable_substructure_events();
 }
@@ -731,7 +1112,18 @@ XConnection::place_window(winsys::Window window, winsys::Region& region)
 void
 XConnection::move_window(winsys::Window window, winsys::Pos pos)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->region && shadow->region->pos == pos) {
+        ++m_suppressed_requests.geometry;
+        return;
+    }
+
+    if (write_shadow(window) && shadow->region)
+        shadow->region->pos = pos;
+
     disable_substructure_events();
+    note_crossing_request();
     XMoveWindow(mp_dpy, window, pos.x, pos.y);
     enable_substructure_events();
 }
@@ -739,17 +1131,63 @@ XConnection::move_window(winsys::Window window, winsys::Pos pos)
 void
 XConnection::resize_window(winsys::Window window, winsys::Dim dim)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->region && shadow->region->dim == dim) {
+        ++m_suppressed_requests.geometry;
+        return;
+    }
+
+    if (write_shadow(window) && shadow->region)
+        shadow->region->dim = dim;
+
     disable_substructure_events();
+    note_crossing_request();
     XResizeWindow(mp_dpy, window, dim.w, dim.h);
     enable_substructure_events();
 }
 
+void
+XConnection::send_sync_request(winsys::Window window)
+{
+    auto sync = m_sync_counters.find(window);
+
+    if (sync == m_sync_counters.end())
+        return;
+
+    std::int64_t value = ++sync->second.value;
+
+    XSyncAlarmAttributes attributes;
+    XSyncIntsToValue(
+        &attributes.trigger.wait_value,
+        static_cast<unsigned>(value & 0xffffffff),
+        static_cast<int>(value >> 32)
+    );
+
+    XSyncChangeAlarm(mp_dpy, sync->second.alarm, XSyncCAValue, &attributes);
+
+    XEvent event;
+    event.type = ClientMessage;
+    event.xclient.window = window;
+    event.xclient.message_type = get_netwm_atom(NetWMID::WMProtocols);
+    event.xclient.format = 32;
+    event.xclient.data.l[0] = get_netwm_atom(NetWMID::NetWMSyncRequest);
+    event.xclient.data.l[1] = CurrentTime;
+    event.xclient.data.l[2] = value & 0xffffffff;
+    event.xclient.data.l[3] = value >> 32;
+    event.xclient.data.l[4] = 0;
+    XSendEvent(mp_dpy, window, False, NoEventMask, &event);
+}
+
 void
 XConnection::focus_window(winsys::Window window)
 {
     if (window == None)
         window = m_root;
 
+    m_focus_serial = NextRequest(mp_dpy);
+    m_focus_shadow = window;
+
     XSetInputFocus(mp_dpy, window, RevertToNone, CurrentTime);
 }
 
@@ -766,6 +1204,7 @@ XConnection::stack_window_above(winsys::Window window, std::optional<winsys::Win
         mask |= CWSibling;
     }
 
+    note_crossing_request();
     XConfigureWindow(mp_dpy, window, mask, &wc);
 }
 
@@ -782,6 +1221,7 @@ XConnection::stack_window_below(winsys::Window window, std::optional<winsys::Win
         mask |= CWSibling;
     }
 
+    note_crossing_request();
     XConfigureWindow(mp_dpy, window, mask, &wc);
 }
 
@@ -815,24 +1255,24 @@ XConnection::grab_bindings(std::vector<winsys::KeyInput>& key_inputs, std::vecto
         Mod5Mask
     };
 
-    for (auto& modifier : modifiers_to_ignore) {
-        for (auto& key_input : key_inputs)
-            XGrabKey(mp_dpy,
-                get_keycode(key_input.key),
-                std::accumulate(
-                    key_input.modifiers.begin(),
-                    key_input.modifiers.end(),
-                    0,
-                    [modifier_to_x11](std::size_t const& lhs, winsys::Modifier const& rhs) {
-                        return lhs | modifier_to_x11(rhs);
-                    }
-                ) | modifier,
-                m_root,
-                True,
-                GrabModeAsync,
-                GrabModeAsync
-            );
+    m_key_grabs.clear();
+    m_key_grabs.reserve(key_inputs.size());
 
+    for (auto& key_input : key_inputs) {
+        unsigned modifiers = std::accumulate(
+            key_input.modifiers.begin(),
+            key_input.modifiers.end(),
+            0,
+            [modifier_to_x11](std::size_t const& lhs, winsys::Modifier const& rhs) {
+                return lhs | modifier_to_x11(rhs);
+            }
+        );
+
+        m_key_grabs.emplace_back(key_input.key, modifiers);
+        grab_key(get_keycode(key_input.key), modifiers);
+    }
+
+    for (auto& modifier : modifiers_to_ignore) {
         for (auto& mouse_input : mouse_inputs)
             XGrabButton(mp_dpy,
                 get_buttoncode(mouse_input.button),
@@ -863,52 +1303,60 @@ XConnection::grab_bindings(std::vector<winsys::KeyInput>& key_inputs, std::vecto
     flush();
 }
 
-void
-XConnection::regrab_buttons(winsys::Window window)
-{
-    static const long regrab_event_mask
-        = ButtonPressMask | ButtonReleaseMask;
-
-    XGrabButton(mp_dpy,
-        AnyButton,
-        AnyModifier,
-        window,
-        True,
-        regrab_event_mask,
-        GrabModeAsync,
-        GrabModeAsync,
-        None,
-        None
-    );
-}
-
-void
-XConnection::ungrab_buttons(winsys::Window window)
-{
-    XUngrabButton(mp_dpy, AnyButton, AnyModifier, window);
-}
-
 void
 XConnection::unfocus()
 {
+    m_focus_serial = NextRequest(mp_dpy);
+    m_focus_shadow = m_root;
+
     XSetInputFocus(mp_dpy, m_root, m_check_window, CurrentTime);
 }
 
 void
 XConnection::set_window_border_width(winsys::Window window, unsigned width)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->border_width == width) {
+        ++m_suppressed_requests.border_width;
+        return;
+    }
+
+    if (write_shadow(window))
+        shadow->border_width = width;
+
     XSetWindowBorderWidth(mp_dpy, window, width);
 }
 
 void
 XConnection::set_window_border_color(winsys::Window window, unsigned color)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->border_color == color) {
+        ++m_suppressed_requests.border_color;
+        return;
+    }
+
+    if (shadow)
+        shadow->border_color = color;
+
     XSetWindowBorder(mp_dpy, window, color);
 }
 
 void
 XConnection::set_window_background_color(winsys::Window window, unsigned color)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->background_color == color) {
+        ++m_suppressed_requests.background_color;
+        return;
+    }
+
+    if (shadow)
+        shadow->background_color = color;
+
     XSetWindowBackground(mp_dpy, window, color);
     XClearWindow(mp_dpy, window);
 }
@@ -926,17 +1374,31 @@ XConnection::set_window_notify_enter(winsys::Window window, bool notify_enter)
     if (notify_enter)
         wa.event_mask |= EnterWindowMask;
 
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->event_mask == wa.event_mask) {
+        ++m_suppressed_requests.event_mask;
+        return;
+    }
+
+    if (shadow)
+        shadow->event_mask = wa.event_mask;
+
     XChangeWindowAttributes(mp_dpy, window, CWEventMask, &wa);
 }
 
 void
-XConnection::update_window_offset(winsys::Window window, winsys::Window frame)
+XConnection::update_window_offset(winsys::Window window, winsys::Region offset)
 {
-    XWindowAttributes fa;
-    XWindowAttributes wa;
+    WindowShadow* shadow = get_shadow(window);
 
-    XGetWindowAttributes(mp_dpy, frame, &fa);
-    XGetWindowAttributes(mp_dpy, window, &wa);
+    if (shadow && shadow->offset == offset) {
+        ++m_suppressed_requests.offset;
+        return;
+    }
+
+    if (shadow)
+        shadow->offset = offset;
 
     XEvent event;
     event.type = ConfigureNotify;
@@ -944,10 +1406,10 @@ XConnection::update_window_offset(winsys::Window window, winsys::Window frame)
     event.xconfigure.display = mp_dpy;
     event.xconfigure.event = window;
     event.xconfigure.window = window;
-    event.xconfigure.x = fa.x + wa.x;
-    event.xconfigure.y = fa.y + wa.x;
-    event.xconfigure.width = wa.width;
-    event.xconfigure.height = wa.height;
+    event.xconfigure.x = offset.pos.x;
+    event.xconfigure.y = offset.pos.y;
+    event.xconfigure.width = offset.dim.w;
+    event.xconfigure.height = offset.dim.h;
     event.xconfigure.border_width = 0;
     event.xconfigure.above = None;
     event.xconfigure.override_redirect = True;
@@ -955,24 +1417,49 @@ XConnection::update_window_offset(winsys::Window window, winsys::Window frame)
     XSendEvent(mp_dpy, window, False, StructureNotifyMask, &event);
 }
 
+void
+XConnection::update_window_offsets(std::vector<std::pair<winsys::Window, winsys::Region>> const& offsets)
+{
+    for (auto& [window,offset] : offsets)
+        update_window_offset(window, offset);
+}
+
 winsys::Window
 XConnection::get_focused_window()
 {
-    winsys::Window window;
+    if (m_focus_shadow)
+        return *m_focus_shadow;
+
+    report_round_trip("GetInputFocus");
+
+    winsys::Window window;
     int _i;
 
+    m_focus_serial = NextRequest(mp_dpy);
     XGetInputFocus(mp_dpy, &window, &_i);
+
+    m_focus_shadow = window;
     return window;
 }
 
 std::optional<winsys::Region>
 XConnection::get_window_geometry(winsys::Window window)
 {
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow && shadow->region)
+        return shadow->region;
+
+    report_round_trip("GetWindowAttributes");
+
+    if (shadow)
+        shadow->serial = NextRequest(mp_dpy);
+
     static XWindowAttributes wa;
     if (!XGetWindowAttributes(mp_dpy, window, &wa))
         return std::nullopt;
 
-    return winsys::Region {
+    winsys::Region region = winsys::Region {
         winsys::Pos {
             wa.x,
             wa.y
@@ -982,11 +1469,25 @@ XConnection::get_window_geometry(winsys::Window window)
             wa.height
         }
     };
+
+    if (shadow)
+        shadow->region = region;
+
+    return region;
 }
 
 std::optional<winsys::Pid>
 XConnection::get_window_pid(winsys::Window window)
 {
+    auto prefetched = m_prefetched_pids.find(window);
+
+    if (prefetched != m_prefetched_pids.end()) {
+        std::optional<winsys::Pid> pid = prefetched->second;
+        m_prefetched_pids.erase(prefetched);
+
+        return pid;
+    }
+
     XResClientIdSpec spec{
         window,
         XRES_CLIENT_ID_PID_MASK
@@ -999,6 +1500,7 @@ XConnection::get_window_pid(winsys::Window window)
 
     std::optional<winsys::Pid> pid = std::nullopt;
 
+    report_round_trip("XResQueryClientIds");
     if (!XResQueryClientIds(mp_dpy, 1, client_specs, &n_values, &client_values))
         for (long i = 0; i < n_values; ++i)
             if ((client_values[i].spec.mask & XRES_CLIENT_ID_PID_MASK) != 0) {
@@ -1019,95 +1521,152 @@ yield:
     return pid;
 }
 
-std::optional<winsys::Pid>
-XConnection::get_ppid(std::optional<winsys::Pid> pid)
+void
+XConnection::prefetch_pids(std::vector<winsys::Window> const& windows)
 {
-    if (!pid)
-        return std::nullopt;
+    if (windows.empty())
+        return;
 
-    proc_t proc;
-    memset(&proc, 0, sizeof(proc));
-    PROCTAB* ptab = openproc(PROC_FILLSTATUS | PROC_PID, &pid);
+    std::vector<XResClientIdSpec> client_specs;
+    client_specs.reserve(windows.size());
 
-    std::optional<winsys::Pid> ppid = std::nullopt;
+    for (winsys::Window window : windows)
+        client_specs.push_back(XResClientIdSpec{
+            window,
+            XRES_CLIENT_ID_PID_MASK
+        });
 
-    if (readproc(ptab, &proc) != 0 && proc.ppid > 0) {
-        ppid = proc.ppid;
-        goto yield;
-    }
+    long n_values = 0;
+    XResClientIdValue* client_values = nullptr;
 
-yield:
-    closeproc(ptab);
-    return ppid;
+    // values identify the owning client by its resource base, which is
+    // shared by every window that client created
+    std::unordered_map<XID, winsys::Pid> client_pids;
+
+    report_round_trip("XResQueryClientIds");
+    if (!XResQueryClientIds(mp_dpy, client_specs.size(), client_specs.data(), &n_values, &client_values))
+        for (long i = 0; i < n_values; ++i)
+            if ((client_values[i].spec.mask & XRES_CLIENT_ID_PID_MASK) != 0) {
+                CARD32* client_value
+                    = reinterpret_cast<CARD32*>(client_values[i].value);
+
+                if (client_value && *client_value > 0)
+                    client_pids[client_values[i].spec.client]
+                        = static_cast<winsys::Pid>(*client_value);
+            }
+
+    XFree(client_values);
+
+    XID resource_mask = xcb_get_setup(XGetXCBConnection(mp_dpy))->resource_id_mask;
+
+    for (winsys::Window window : windows) {
+        auto pid = client_pids.find(window & ~resource_mask);
+
+        m_prefetched_pids[window] = pid != client_pids.end()
+            ? std::optional<winsys::Pid>(pid->second)
+            : std::nullopt;
+    }
 }
 
 bool
 XConnection::must_manage_window(winsys::Window window)
 {
-    static const std::vector<winsys::WindowType> ignore_types{
-        winsys::WindowType::Desktop,
-        winsys::WindowType::Dock,
-        winsys::WindowType::Toolbar,
-        winsys::WindowType::Menu,
-        winsys::WindowType::Splash,
-        winsys::WindowType::DropdownMenu,
-        winsys::WindowType::PopupMenu,
-        winsys::WindowType::Tooltip,
-        winsys::WindowType::Notification,
-        winsys::WindowType::Combo,
-        winsys::WindowType::Dnd,
-    };
-
     XWindowAttributes wa;
+
+    report_round_trip("GetWindowAttributes");
     return XGetWindowAttributes(mp_dpy, window, &wa)
         && wa.c_class != InputOnly
         && !wa.override_redirect
-        && !window_is_any_of_types(window, ignore_types);
+        && !is_unmanaged_window_type(get_window_types(window));
 }
 
 bool
 XConnection::must_free_window(winsys::Window window)
 {
-    static const std::vector<winsys::WindowState> free_states{
-        winsys::WindowState::Modal
-    };
+    return is_free_window(
+        get_window_desktop(window),
+        get_window_states(window),
+        get_window_types(window),
+        get_icccm_window_size_hints(window, std::nullopt)
+    );
+}
 
-    static const std::vector<winsys::WindowType> free_types{
-        winsys::WindowType::Dialog,
-        winsys::WindowType::Utility,
-    };
+bool
+XConnection::window_is_mappable(winsys::Window window)
+{
+    XWindowAttributes wa;
 
-    std::optional<Index> desktop = get_window_desktop(window);
+    report_round_trip("GetWindowAttributes");
+    XGetWindowAttributes(mp_dpy, window, &wa);
 
-    if ((desktop && *desktop == 0xFFFFFFFF)
-        || window_is_any_of_states(window, free_states)
-        || window_is_any_of_types(window, free_types))
-    {
-        return true;
-    }
+    return wa.c_class != InputOnly;
+}
+
+winsys::WindowSnapshot
+XConnection::fetch_window_snapshot(winsys::Window window)
+{
+    winsys::WindowSnapshot snapshot{};
+    snapshot.window = window;
 
     XWindowAttributes wa;
-    XGetWindowAttributes(mp_dpy, window, &wa);
 
-    std::optional<winsys::SizeHints> sh
-        = get_icccm_window_size_hints(window, std::nullopt);
+    report_round_trip("GetWindowAttributes");
+    if (XGetWindowAttributes(mp_dpy, window, &wa)) {
+        snapshot.geometry = winsys::Region {
+            winsys::Pos {
+                wa.x,
+                wa.y
+            },
+            winsys::Dim {
+                wa.width,
+                wa.height
+            }
+        };
 
-    if (sh) {
-        if (sh->min_width && sh->min_height && sh->max_width && sh->max_height)
-            return *sh->max_width > 0 && *sh->max_height > 0
-                && *sh->max_width == *sh->min_width && *sh->max_height == *sh->min_height;
+        snapshot.mappable = wa.c_class != InputOnly;
     }
 
-    return false;
+    snapshot.pid = get_window_pid(window);
+    snapshot.name = get_icccm_window_name(window);
+    snapshot.class_ = get_icccm_window_class(window);
+    snapshot.instance = get_icccm_window_instance(window);
+    snapshot.types = get_window_types(window);
+    snapshot.states = get_window_states(window);
+    snapshot.desktop = get_window_desktop(window);
+    snapshot.hints = get_icccm_window_hints(window);
+    snapshot.size_hints = get_icccm_window_size_hints(window, std::nullopt);
+    snapshot.transient_for = get_icccm_window_transient_for(window);
+    snapshot.client_leader = get_icccm_window_client_leader(window);
+    snapshot.struts = get_window_strut(window);
+
+    snapshot.manageable = snapshot.geometry
+        && snapshot.mappable
+        && !wa.override_redirect
+        && !is_unmanaged_window_type(snapshot.types);
+
+    snapshot.must_free = is_free_window(
+        snapshot.desktop,
+        snapshot.states,
+        snapshot.types,
+        snapshot.size_hints
+    );
+
+    return snapshot;
 }
 
-bool
-XConnection::window_is_mappable(winsys::Window window)
+std::vector<winsys::WindowSnapshot>
+XConnection::fetch_window_snapshots(std::vector<winsys::Window> const& windows)
 {
-    XWindowAttributes wa;
-    XGetWindowAttributes(mp_dpy, window, &wa);
+    prefetch_pids(windows);
 
-    return wa.c_class != InputOnly;
+    std::vector<winsys::WindowSnapshot> snapshots;
+    snapshots.reserve(windows.size());
+
+    for (winsys::Window window : windows)
+        snapshots.push_back(fetch_window_snapshot(window));
+
+    m_prefetched_pids.clear();
+    return snapshots;
 }
 
 // ICCCM
@@ -1124,7 +1683,7 @@ XConnection::set_icccm_window_state(winsys::Window window, winsys::IcccmWindowSt
     }
 
     long data[] = { window_state, None };
-    XChangeProperty(mp_dpy, window, get_atom("WM_STATE"), get_atom("WM_STATE"), 32,
+    XChangeProperty(mp_dpy, window, get_netwm_atom(NetWMID::WMState), get_netwm_atom(NetWMID::WMState), 32,
         PropModeReplace, reinterpret_cast<const unsigned char*>(data), 2);
 }
 
@@ -1134,6 +1693,7 @@ XConnection::set_icccm_window_hints(winsys::Window window, winsys::Hints hints)
     bool success = false;
     XWMHints hints_;
 
+    report_round_trip("GetProperty");
     XWMHints* x_hints = XGetWMHints(mp_dpy, window);
     if (x_hints) {
         std::memcpy(&hints_, x_hints, sizeof(XWMHints));
@@ -1158,7 +1718,7 @@ XConnection::get_icccm_window_name(winsys::Window window)
     std::string name;
     char name_raw[512];
 
-    if (!get_text_property(window, get_atom("_NET_WM_NAME"), name_raw, sizeof name_raw))
+    if (!get_text_property(window, get_netwm_atom(NetWMID::NetWMName), name_raw, sizeof name_raw))
         get_text_property(window, XA_WM_NAME, name_raw, sizeof name_raw);
 
     if (name_raw[0] == '\0')
@@ -1174,6 +1734,7 @@ XConnection::get_icccm_window_class(winsys::Window window)
     std::string class_ = "N/a";
 
     XClassHint* hint = XAllocClassHint();
+    report_round_trip("GetProperty");
     XGetClassHint(mp_dpy, window, hint);
 
     if (hint->res_class) {
@@ -1190,6 +1751,7 @@ XConnection::get_icccm_window_instance(winsys::Window window)
     std::string instance = "N/a";
 
     XClassHint* hint = XAllocClassHint();
+    report_round_trip("GetProperty");
     XGetClassHint(mp_dpy, window, hint);
 
     if (hint->res_name) {
@@ -1204,6 +1766,7 @@ std::optional<winsys::Window>
 XConnection::get_icccm_window_transient_for(winsys::Window window)
 {
     winsys::Window transient = None;
+    report_round_trip("GetProperty");
     XGetTransientForHint(mp_dpy, window, &transient);
 
     return transient == None ? std::nullopt : std::optional(transient);
@@ -1212,7 +1775,7 @@ XConnection::get_icccm_window_transient_for(winsys::Window window)
 std::optional<winsys::Window>
 XConnection::get_icccm_window_client_leader(winsys::Window window)
 {
-    winsys::Window leader = get_window_property(window, "WM_CLIENT_LEADER");
+    winsys::Window leader = get_window_property(window, NetWMID::WMClientLeader);
 
     if (!property_status_ok() || leader == None)
         return std::nullopt;
@@ -1226,6 +1789,7 @@ XConnection::get_icccm_window_hints(winsys::Window window)
     bool success = false;
     XWMHints hints;
 
+    report_round_trip("GetProperty");
     XWMHints* x_hints = XGetWMHints(mp_dpy, window);
     if (x_hints) {
         std::memcpy(&hints, x_hints, sizeof(XWMHints));
@@ -1236,6 +1800,23 @@ XConnection::get_icccm_window_hints(winsys::Window window)
     if (!success)
         return std::nullopt;
 
+    return get_hints_from_wmhints(hints);
+}
+
+std::optional<winsys::SizeHints>
+XConnection::get_icccm_window_size_hints(winsys::Window window, std::optional<winsys::Dim> min_window_dim)
+{
+    XSizeHints sh;
+    report_round_trip("GetProperty");
+    if (XGetNormalHints(mp_dpy, window, &sh) == 0)
+        return std::nullopt;
+
+    return get_size_hints_from_sizehints(sh, min_window_dim);
+}
+
+std::optional<winsys::Hints>
+XConnection::get_hints_from_wmhints(XWMHints const& hints) const
+{
     std::optional<winsys::IcccmWindowState> initial_state;
 
     switch (hints.initial_state) {
@@ -1258,12 +1839,8 @@ XConnection::get_icccm_window_hints(winsys::Window window)
 }
 
 std::optional<winsys::SizeHints>
-XConnection::get_icccm_window_size_hints(winsys::Window window, std::optional<winsys::Dim> min_window_dim)
+XConnection::get_size_hints_from_sizehints(XSizeHints const& sh, std::optional<winsys::Dim> min_window_dim) const
 {
-    XSizeHints sh;
-    if (XGetNormalHints(mp_dpy, window, &sh) == 0)
-        return std::nullopt;
-
     std::optional<winsys::Pos> pos = std::nullopt;
     std::optional<unsigned> sh_min_width = std::nullopt;
     std::optional<unsigned> sh_min_height = std::nullopt;
@@ -1386,6 +1963,10 @@ XConnection::init_for_wm(std::vector<std::string> const& desktop_names)
 
     check_otherwm();
 
+    // output hotplug and mode changes are reported as screen changes
+    if (m_randr_available)
+        XRRSelectInput(mp_dpy, m_root, RRScreenChangeNotifyMask);
+
     map_window(m_check_window);
     stack_window_below(m_check_window, std::nullopt);
 
@@ -1395,14 +1976,14 @@ XConnection::init_for_wm(std::vector<std::string> const& desktop_names)
 
     std::vector<std::string> wm_class{ m_wm_name, m_wm_name };
 
-    replace_string_property(m_check_window, "_NET_WM_NAME", m_wm_name);
-    replace_stringlist_property(m_check_window, "_WM_CLASS", wm_class);
-    replace_card_property(m_check_window, "_NET_WM_PID", getpid());
-    replace_window_property(m_check_window, "_NET_SUPPORTING_WM_CHECK", m_check_window);
+    replace_string_property(m_check_window, NetWMID::NetWMName, m_wm_name);
+    replace_stringlist_property(m_check_window, NetWMID::WMClass, wm_class);
+    replace_card_property(m_check_window, NetWMID::NetWMPid, getpid());
+    replace_window_property(m_check_window, NetWMID::NetSupportingWMCheck, m_check_window);
 
-    replace_window_property(m_root, "_NET_SUPPORTING_WM_CHECK", m_check_window);
-    replace_string_property(m_root, "_NET_WM_NAME", m_wm_name);
-    replace_stringlist_property(m_root, "_WM_CLASS", wm_class);
+    replace_window_property(m_root, NetWMID::NetSupportingWMCheck, m_check_window);
+    replace_string_property(m_root, NetWMID::NetWMName, m_wm_name);
+    replace_stringlist_property(m_root, NetWMID::WMClass, wm_class);
 
     std::vector<Atom> supported_atoms;
     supported_atoms.reserve(NetWMID::NetLast);
@@ -1410,9 +1991,9 @@ XConnection::init_for_wm(std::vector<std::string> const& desktop_names)
     for (NetWMID i = NetWMID::NetFirst; i < NetWMID::NetLast; ++i)
         supported_atoms.push_back(get_netwm_atom(i));
 
-    replace_atomlist_property(m_root, "_NET_SUPPORTED", supported_atoms);
-    replace_card_property(m_root, "_NET_WM_PID", getpid());
-    unset_window_property(m_root, "_NET_CLIENT_LIST");
+    replace_atomlist_property(m_root, NetWMID::NetSupported, supported_atoms);
+    replace_card_property(m_root, NetWMID::NetWMPid, getpid());
+    unset_window_property(m_root, NetWMID::NetClientList);
 
     update_desktops(desktop_names);
 }
@@ -1420,19 +2001,19 @@ XConnection::init_for_wm(std::vector<std::string> const& desktop_names)
 void
 XConnection::set_current_desktop(Index index)
 {
-    replace_card_property(m_root, "_NET_CURRENT_DESKTOP", index);
+    replace_card_property(m_root, NetWMID::NetCurrentDesktop, index);
 }
 
 void
 XConnection::set_root_window_name(std::string const& name)
 {
-    replace_string_property(m_root, "WM_NAME", name);
+    replace_string_property(m_root, NetWMID::WMName, name);
 }
 
 void
 XConnection::set_window_desktop(winsys::Window window, Index index)
 {
-    replace_card_property(window, "_NET_WM_DESKTOP", index);
+    replace_card_property(window, NetWMID::NetWMDesktop, index);
 }
 
 void
@@ -1447,10 +2028,10 @@ XConnection::set_window_state(winsys::Window window, winsys::WindowState state,
         if (window_is_any_of_states(window, check_state))
             return;
 
-        append_atomlist_property(window, "_NET_WM_STATE", atom);
+        append_atomlist_property(window, NetWMID::NetWMState, atom);
     } else {
         std::vector<Atom> atoms
-            = get_atomlist_property(window, "_NET_WM_STATE");
+            = get_atomlist_property(window, NetWMID::NetWMState);
 
         if (!property_status_ok())
             return;
@@ -1464,7 +2045,7 @@ XConnection::set_window_state(winsys::Window window, winsys::WindowState state,
             atoms.end()
         );
 
-        replace_atomlist_property(window, "_NET_WM_STATE", atoms);
+        replace_atomlist_property(window, NetWMID::NetWMState, atoms);
     }
 }
 
@@ -1478,7 +2059,7 @@ XConnection::set_window_frame_extents(winsys::Window window, winsys::Extents ext
         static_cast<unsigned>(extents.bottom)
     };
 
-    replace_cardlist_property(window, "_NET_FRAME_EXTENTS", frame_extents);
+    replace_cardlist_property(window, NetWMID::NetWMFrameExtents, frame_extents);
 }
 
 void
@@ -1492,7 +2073,7 @@ XConnection::set_desktop_geometry(std::vector<winsys::Region> const& geometries)
         values.push_back(geometry.dim.h);
     }
 
-    replace_cardlist_property(m_root, "_NET_DESKTOP_GEOMETRY", values);
+    replace_cardlist_property(m_root, NetWMID::NetDesktopGeometry, values);
 }
 
 void
@@ -1506,7 +2087,7 @@ XConnection::set_desktop_viewport(std::vector<winsys::Region> const& viewports)
         values.push_back(viewport.pos.y);
     }
 
-    replace_cardlist_property(m_root, "_NET_DESKTOP_VIEWPORT", values);
+    replace_cardlist_property(m_root, NetWMID::NetDesktopViewport, values);
 }
 
 void
@@ -1522,26 +2103,26 @@ XConnection::set_workarea(std::vector<winsys::Region> const& workareas)
         values.push_back(workarea.dim.h);
     }
 
-    replace_cardlist_property(m_root, "_NET_WORKAREA", values);
+    replace_cardlist_property(m_root, NetWMID::NetWorkarea, values);
 }
 
 void
 XConnection::update_desktops(std::vector<std::string> const& desktop_names)
 {
-    replace_card_property(m_root, "_NET_NUMBER_OF_DESKTOPS", desktop_names.size());
-    replace_stringlist_property(m_root, "_NET_DESKTOP_NAMES", desktop_names);
+    replace_card_property(m_root, NetWMID::NetNumberOfDesktops, desktop_names.size());
+    replace_stringlist_property(m_root, NetWMID::NetDesktopNames, desktop_names);
 }
 
 void
 XConnection::update_client_list(std::vector<winsys::Window> const& clients)
 {
-    replace_windowlist_property(m_root, "_NET_CLIENT_LIST", clients);
+    update_windowlist_property(m_root, NetWMID::NetClientList, m_client_list, clients);
 }
 
 void
 XConnection::update_client_list_stacking(std::vector<winsys::Window> const& clients)
 {
-    replace_windowlist_property(m_root, "_NET_CLIENT_LIST_STACKING", clients);
+    update_windowlist_property(m_root, NetWMID::NetClientListStacking, m_client_list_stacking, clients);
 }
 
 std::optional<std::vector<std::optional<winsys::Strut>>>
@@ -1553,7 +2134,7 @@ XConnection::get_window_strut(winsys::Window window)
     if (struts_partial)
         return struts_partial;
 
-    std::vector<unsigned long> strut_widths = get_cardlist_property(window, "_NET_WM_STRUT");
+    std::vector<unsigned long> strut_widths = get_cardlist_property(window, NetWMID::NetWMStrut);
 
     if (!property_status_ok() || strut_widths.empty())
         return std::nullopt;
@@ -1579,7 +2160,7 @@ XConnection::get_window_strut(winsys::Window window)
 std::optional<std::vector<std::optional<winsys::Strut>>>
 XConnection::get_window_strut_partial(winsys::Window window)
 {
-    std::vector<unsigned long> strut_widths = get_cardlist_property(window, "_NET_WM_STRUT_PARTIAL");
+    std::vector<unsigned long> strut_widths = get_cardlist_property(window, NetWMID::NetWMStrutPartial);
 
     if (!property_status_ok() || strut_widths.empty())
         return std::nullopt;
@@ -1605,142 +2186,645 @@ XConnection::get_window_strut_partial(winsys::Window window)
 std::optional<Index>
 XConnection::get_window_desktop(winsys::Window window)
 {
-    Index index = get_card_property(window, "_NET_WM_DESKTOP");
+    Index index = get_card_property(window, NetWMID::NetWMDesktop);
+
+    if (!property_status_ok())
+        return std::nullopt;
+
+    return index;
+}
+
+winsys::EnumSet<winsys::WindowType>
+XConnection::get_window_types(winsys::Window window)
+{
+    std::vector<Atom> window_type_atoms = get_atomlist_property(window, NetWMID::NetWMWindowType);
+
+    if (!property_status_ok())
+        return {};
+
+    winsys::EnumSet<winsys::WindowType> window_types{};
+
+    for (Atom atom : window_type_atoms)
+        window_types.insert(get_window_type_from_atom(atom));
+
+    return window_types;
+}
+
+winsys::EnumSet<winsys::WindowState>
+XConnection::get_window_states(winsys::Window window)
+{
+    std::vector<Atom> window_state_atoms = get_atomlist_property(window, NetWMID::NetWMState);
+
+    if (!property_status_ok())
+        return {};
+
+    winsys::EnumSet<winsys::WindowState> window_states{};
+
+    for (Atom atom : window_state_atoms)
+        window_states.insert(get_window_state_from_atom(atom));
+
+    return window_states;
+}
+
+bool
+XConnection::window_is_fullscreen(winsys::Window window)
+{
+    static const std::vector<winsys::WindowState> fullscreen_state{
+        winsys::WindowState::Fullscreen
+    };
+
+    return window_is_any_of_states(window, fullscreen_state);
+}
+
+bool
+XConnection::window_is_above(winsys::Window window)
+{
+    static const std::vector<winsys::WindowState> above_state{
+        winsys::WindowState::Above_
+    };
+
+    return window_is_any_of_states(window, above_state);
+}
+
+bool
+XConnection::window_is_below(winsys::Window window)
+{
+    static const std::vector<winsys::WindowState> below_state{
+        winsys::WindowState::Below_
+    };
+
+    return window_is_any_of_states(window, below_state);
+}
+
+bool
+XConnection::window_is_sticky(winsys::Window window)
+{
+    static const std::vector<winsys::WindowState> sticky_state{
+        winsys::WindowState::Sticky
+    };
+
+    return window_is_any_of_states(window, sticky_state);
+}
+
+
+// IPC client
+void
+XConnection::init_for_client()
+{
+
+}
+
+
+XConnection::SuppressedRequests const&
+XConnection::suppressed_requests() const
+{
+    return m_suppressed_requests;
+}
+
+XConnection::CompactedEvents const&
+XConnection::compacted_events() const
+{
+    return m_compacted_events;
+}
+
+void
+XConnection::track_window(winsys::Window window)
+{
+    m_window_shadows.try_emplace(window, WindowShadow {
+        0,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        std::nullopt
+    });
+}
+
+void
+XConnection::untrack_window(winsys::Window window)
+{
+    m_window_shadows.erase(window);
+}
+
+XConnection::WindowShadow*
+XConnection::get_shadow(winsys::Window window)
+{
+    std::unordered_map<winsys::Window, WindowShadow>::iterator iter
+        = m_window_shadows.find(window);
+
+    if (iter == m_window_shadows.end())
+        return nullptr;
+
+    return &iter->second;
+}
+
+XConnection::WindowShadow*
+XConnection::write_shadow(winsys::Window window)
+{
+    WindowShadow* shadow = get_shadow(window);
+
+    if (shadow)
+        shadow->serial = NextRequest(mp_dpy);
+
+    return shadow;
+}
+
+void
+XConnection::update_shadows(XEvent const& event)
+{
+    WindowShadow* shadow = nullptr;
+
+    switch (event.type) {
+    case ConfigureNotify:
+    {
+        shadow = get_shadow(event.xconfigure.window);
+
+        if (shadow && event.xconfigure.serial >= shadow->serial) {
+            shadow->region = winsys::Region {
+                winsys::Pos {
+                    event.xconfigure.x,
+                    event.xconfigure.y
+                },
+                winsys::Dim {
+                    event.xconfigure.width,
+                    event.xconfigure.height
+                }
+            };
+
+            shadow->border_width = event.xconfigure.border_width;
+        }
+
+        break;
+    }
+    case ReparentNotify:
+    {
+        shadow = get_shadow(event.xreparent.window);
+
+        if (shadow && event.xreparent.serial >= shadow->serial && shadow->region)
+            shadow->region->pos = winsys::Pos {
+                event.xreparent.x,
+                event.xreparent.y
+            };
+
+        break;
+    }
+    case MapNotify:
+    {
+        shadow = get_shadow(event.xmap.window);
+
+        if (shadow && event.xmap.serial >= shadow->serial)
+            shadow->mapped = true;
+
+        break;
+    }
+    case UnmapNotify:
+    {
+        shadow = get_shadow(event.xunmap.window);
+
+        if (shadow && event.xunmap.serial >= shadow->serial)
+            shadow->mapped = false;
+
+        break;
+    }
+    case DestroyNotify: untrack_window(event.xdestroywindow.window); break;
+    case FocusIn: // fallthrough
+    case FocusOut:
+    {
+        XFocusChangeEvent focus = event.xfocus;
+
+        if (focus.serial < m_focus_serial
+            || focus.mode == NotifyGrab || focus.mode == NotifyUngrab)
+        {
+            break;
+        }
+
+        switch (focus.detail) {
+        case NotifyAncestor: // fallthrough
+        case NotifyInferior: // fallthrough
+        case NotifyNonlinear:
+        {
+            if (event.type == FocusIn)
+                m_focus_shadow = focus.window;
+            else if (m_focus_shadow == focus.window)
+                m_focus_shadow = std::nullopt;
+
+            break;
+        }
+        case NotifyVirtual: // fallthrough
+        case NotifyNonlinearVirtual: break;
+        default: m_focus_shadow = std::nullopt; break;
+        }
+
+        break;
+    }
+    default: break;
+    }
+
+    // the pointer is only reported while it is over our own windows, so its
+    // position is trusted only for events that carry it, or while grabbed
+    switch (event.type) {
+    case MotionNotify:
+        m_pointer_shadow = winsys::Pos { event.xmotion.x_root, event.xmotion.y_root };
+        break;
+    case ButtonPress: // fallthrough
+    case ButtonRelease:
+        m_pointer_shadow = winsys::Pos { event.xbutton.x_root, event.xbutton.y_root };
+        break;
+    case KeyPress: // fallthrough
+    case KeyRelease:
+        m_pointer_shadow = winsys::Pos { event.xkey.x_root, event.xkey.y_root };
+        break;
+    case EnterNotify: // fallthrough
+    case LeaveNotify:
+        m_pointer_shadow = winsys::Pos { event.xcrossing.x_root, event.xcrossing.y_root };
+        break;
+    default:
+        if (!m_confined_to)
+            m_pointer_shadow = std::nullopt;
+
+        break;
+    }
+}
+
+void
+XConnection::report_round_trip([[maybe_unused]] const char* request)
+{
+#ifdef DEBUG
+    if (m_handling_event) {
+        ++m_round_trips;
+
+        spdlog::debug(
+            "synchronous {} while handling event {} ({} so far)",
+            request,
+            m_current_event.type,
+            m_round_trips
+        );
+    }
+#endif
+}
+
+void
+XConnection::enable_substructure_events()
+{
+    if (--m_substructure_level != 0)
+        return;
+
+    if ((m_prev_root_mask & SubstructureNotifyMask) == 0)
+        return;
+
+    XSelectInput(mp_dpy, m_root, m_prev_root_mask | SubstructureNotifyMask);
+    XFlush(mp_dpy);
+}
+
+void
+XConnection::disable_substructure_events()
+{
+    if (++m_substructure_level != 1)
+        return;
+
+    if ((m_prev_root_mask & SubstructureNotifyMask) == 0)
+        return;
+
+    XSelectInput(mp_dpy, m_root, m_prev_root_mask & ~SubstructureNotifyMask);
+    XFlush(mp_dpy);
+}
+
+void
+XConnection::next_event(XEvent& event)
+{
+    if (m_scheduled_event) {
+        event = m_event_batch[*m_scheduled_event];
+        m_event_batch[*m_scheduled_event].type = SPENT_EVENT;
+        m_scheduled_event = std::nullopt;
+        return;
+    }
+
+    XNextEvent(mp_dpy, &event);
+}
+
+bool
+XConnection::typed_event(XEvent& event, int type)
+{
+    return XCheckTypedEvent(mp_dpy, type, &event);
+}
+
+void
+XConnection::last_typed_event(XEvent& event, int type)
+{
+    while (typed_event(event, type));
+}
+
+void
+XConnection::read_event_batch()
+{
+    // what Xlib holds already, then whatever is waiting on the socket, but no
+    // more than that, so that a flood cannot keep us reading; while the
+    // backlog is full, the socket is left alone and the rest stays queued
+    for (int mode : { QueuedAlready, QueuedAfterReading }) {
+        if (m_event_batch.size() >= MAX_EVENT_BACKLOG)
+            break;
+
+        std::size_t queued = std::min(
+            static_cast<std::size_t>(XEventsQueued(mp_dpy, mode)),
+            MAX_EVENT_BACKLOG - m_event_batch.size()
+        );
+
+        for (std::size_t i = 0; i < queued; ++i) {
+            m_event_batch.emplace_back();
+            XNextEvent(mp_dpy, &m_event_batch.back());
+        }
+    }
+
+    compact_event_batch();
+}
+
+void
+XConnection::compact_event_batch()
+{
+    static constexpr long GEOMETRY_MASK
+        = CWX | CWY | CWWidth | CWHeight | CWBorderWidth;
+
+    m_compacted_events = CompactedEvents{};
+    m_compacted_events.batch = m_event_batch.size();
+
+    m_batch_destroyed.clear();
+    m_batch_properties.clear();
+    m_batch_configures.clear();
+
+    bool later_motion = false;
+
+    // every event is judged by what follows it in the batch, so the batch is
+    // walked back to front; eliminated events are retyped and removed after
+    for (std::size_t i = m_event_batch.size(); i-- > 0;) {
+        XEvent& event = m_event_batch[i];
+        winsys::Window window = event_window(event);
+
+        if (event.type == DestroyNotify) {
+            if (!Util::contains(m_batch_destroyed, window))
+                m_batch_destroyed.push_back(window);
+
+            continue;
+        }
+
+        if (window != None && Util::contains(m_batch_destroyed, window)) {
+            event.type = SPENT_EVENT;
+            ++m_compacted_events.destroyed;
+            continue;
+        }
+
+        switch (event.type) {
+        case MotionNotify:
+        {
+            if (later_motion) {
+                event.type = SPENT_EVENT;
+                ++m_compacted_events.motions;
+            }
+
+            later_motion = true;
+            break;
+        }
+        case EnterNotify:
+        {
+            if (event.xcrossing.mode == NotifyNormal
+                && std::binary_search(
+                    m_crossing_serials.begin(),
+                    m_crossing_serials.end(),
+                    event.xcrossing.serial
+                ))
+            {
+                event.type = SPENT_EVENT;
+                ++m_compacted_events.crossings;
+            }
+
+            break;
+        }
+        case PropertyNotify:
+        {
+            std::pair<winsys::Window, Atom> property
+                = { window, event.xproperty.atom };
+
+            if (Util::contains(m_batch_properties, property)) {
+                event.type = SPENT_EVENT;
+                ++m_compacted_events.properties;
+            } else
+                m_batch_properties.push_back(property);
+
+            break;
+        }
+        case ConfigureRequest:
+        {
+            XConfigureRequestEvent& request = event.xconfigurerequest;
 
-    if (!property_status_ok())
-        return std::nullopt;
+            auto later = std::find_if(
+                m_batch_configures.begin(),
+                m_batch_configures.end(),
+                [window](auto const& configure) {
+                    return configure.first == window;
+                }
+            );
 
-    return index;
-}
+            // requests that restack are kept in order, as only one of
+            // placement or restacking is acted upon per request
+            if ((request.value_mask & ~GEOMETRY_MASK) != 0) {
+                if (later != m_batch_configures.end())
+                    m_batch_configures.erase(later);
 
-std::unordered_set<winsys::WindowType>
-XConnection::get_window_types(winsys::Window window)
-{
-    std::vector<Atom> window_type_atoms = get_atomlist_property(window, "_NET_WM_WINDOW_TYPE");
+                break;
+            }
 
-    if (!property_status_ok())
-        return {};
+            if (later == m_batch_configures.end()) {
+                m_batch_configures.push_back({ window, i });
+                break;
+            }
 
-    std::unordered_set<winsys::WindowType> window_types{};
+            XConfigureRequestEvent& merged
+                = m_event_batch[later->second].xconfigurerequest;
 
-    for (Atom atom : window_type_atoms)
-        window_types.insert(get_window_type_from_atom(atom));
+            if ((merged.value_mask & CWX) == 0)
+                merged.x = request.x;
 
-    return window_types;
-}
+            if ((merged.value_mask & CWY) == 0)
+                merged.y = request.y;
 
-std::unordered_set<winsys::WindowState>
-XConnection::get_window_states(winsys::Window window)
-{
-    std::vector<Atom> window_state_atoms = get_atomlist_property(window, "_NET_WM_STATE");
+            if ((merged.value_mask & CWWidth) == 0)
+                merged.width = request.width;
 
-    if (!property_status_ok())
-        return {};
+            if ((merged.value_mask & CWHeight) == 0)
+                merged.height = request.height;
 
-    std::unordered_set<winsys::WindowState> window_states{};
+            if ((merged.value_mask & CWBorderWidth) == 0)
+                merged.border_width = request.border_width;
 
-    for (Atom atom : window_state_atoms)
-        window_states.insert(get_window_state_from_atom(atom));
+            merged.value_mask |= request.value_mask;
 
-    return window_states;
-}
+            event.type = SPENT_EVENT;
+            ++m_compacted_events.configure_requests;
+            break;
+        }
+        default:
+        {
+            // anything else happening to the window in between breaks up a
+            // run of consecutive configure requests
+            if (window != None)
+                Util::erase_remove_if(m_batch_configures, [window](auto const& configure) {
+                    return configure.first == window;
+                });
 
-bool
-XConnection::window_is_fullscreen(winsys::Window window)
-{
-    static const std::vector<winsys::WindowState> fullscreen_state{
-        winsys::WindowState::Fullscreen
-    };
+            break;
+        }
+        }
+    }
 
-    return window_is_any_of_states(window, fullscreen_state);
-}
+    Util::erase_remove_if(m_event_batch, [](XEvent const& event) {
+        return event.type == SPENT_EVENT;
+    });
 
-bool
-XConnection::window_is_above(winsys::Window window)
-{
-    static const std::vector<winsys::WindowState> above_state{
-        winsys::WindowState::Above_
-    };
+    // once the server has moved past a request, all events it caused have
+    // been read off the socket; any that still carry the serial of the
+    // last processed request were caused by it, as it is always fenced
+    unsigned long processed = LastKnownRequestProcessed(mp_dpy);
 
-    return window_is_any_of_states(window, above_state);
+    Util::erase_remove_if(m_crossing_serials, [processed](unsigned long serial) {
+        return serial < processed;
+    });
+
+#ifdef DEBUG
+    std::size_t eliminated = m_compacted_events.batch - m_event_batch.size();
+
+    if (eliminated > 0)
+        spdlog::debug(
+            "compacted batch of {} events by {}: {} configure requests, "
+            "{} crossings, {} destroyed, {} properties, {} motions",
+            m_compacted_events.batch,
+            eliminated,
+            m_compacted_events.configure_requests,
+            m_compacted_events.crossings,
+            m_compacted_events.destroyed,
+            m_compacted_events.properties,
+            m_compacted_events.motions
+        );
+#endif
 }
 
-bool
-XConnection::window_is_below(winsys::Window window)
+void
+XConnection::dispatch_events(
+    std::function<void(winsys::Event)> const& callback,
+    EventClass class_,
+    std::size_t quantum
+)
 {
-    static const std::vector<winsys::WindowState> below_state{
-        winsys::WindowState::Below_
-    };
+    bool barrier = false;
+    m_batch_blocked.clear();
 
-    return window_is_any_of_states(window, below_state);
-}
+    // input may overtake anything, but other events never overtake a
+    // deferred event for the same window, nor one not tied to a window
+    for (std::size_t i = 0; i < m_event_batch.size() && quantum > 0; ++i) {
+        if (m_event_batch[i].type == SPENT_EVENT)
+            continue;
 
-bool
-XConnection::window_is_sticky(winsys::Window window)
-{
-    static const std::vector<winsys::WindowState> sticky_state{
-        winsys::WindowState::Sticky
-    };
+        EventClass event_class_ = event_class(m_event_batch[i]);
 
-    return window_is_any_of_states(window, sticky_state);
-}
+        if (class_ == EventClass::Input && event_class_ != EventClass::Input)
+            continue;
 
+        bool blocked = false;
 
-// IPC client
-void
-XConnection::init_for_client()
-{
+        if (event_class_ != EventClass::Input) {
+            winsys::Window window = event_window(m_event_batch[i]);
 
-}
+            blocked = barrier || (window == None
+                ? !m_batch_blocked.empty()
+                : m_batch_blocked.count(window) > 0);
 
+            if (event_class_ != class_ || blocked) {
+                if (window == None)
+                    barrier = true;
+                else
+                    m_batch_blocked.insert(window);
+            }
+        }
 
-void
-XConnection::enable_substructure_events()
-{
-    if (--m_substructure_level != 0)
-        return;
+        if (event_class_ == class_ && !blocked) {
+            m_scheduled_event = i;
 
-    if ((m_prev_root_mask & SubstructureNotifyMask) == 0)
-        return;
+            m_handling_event = true;
+            callback(step());
+            m_handling_event = false;
 
-    XSelectInput(mp_dpy, m_root, m_prev_root_mask | SubstructureNotifyMask);
-    XFlush(mp_dpy);
+            --quantum;
+        }
+    }
 }
 
 void
-XConnection::disable_substructure_events()
+XConnection::note_crossing_request()
 {
-    if (++m_substructure_level != 1)
-        return;
-
-    if ((m_prev_root_mask & SubstructureNotifyMask) == 0)
-        return;
-
-    XSelectInput(mp_dpy, m_root, m_prev_root_mask & ~SubstructureNotifyMask);
-    XFlush(mp_dpy);
+    m_crossing_serials.push_back(NextRequest(mp_dpy));
 }
 
 void
-XConnection::next_event(XEvent& event)
+XConnection::fence_crossing_requests()
 {
-    XNextEvent(mp_dpy, &event);
+    // a crossing the pointer causes after the server has processed our last
+    // request carries that request's serial; sending a request behind it
+    // gives such crossings a later serial, so that they are never dropped
+    if (!m_crossing_serials.empty()
+        && m_crossing_serials.back() + 1 == NextRequest(mp_dpy))
+    {
+        XNoOp(mp_dpy);
+    }
 }
 
-bool
-XConnection::typed_event(XEvent& event, int type)
-{
-    return XCheckTypedEvent(mp_dpy, type, &event);
+winsys::Window
+XConnection::event_window(XEvent const& event)
+{
+    switch (event.type) {
+    case MapRequest:       return event.xmaprequest.window;
+    case MapNotify:        return event.xmap.window;
+    case UnmapNotify:      return event.xunmap.window;
+    case DestroyNotify:    return event.xdestroywindow.window;
+    case ReparentNotify:   return event.xreparent.window;
+    case ConfigureRequest: return event.xconfigurerequest.window;
+    case ConfigureNotify:  return event.xconfigure.window;
+    case PropertyNotify:   return event.xproperty.window;
+    case ClientMessage:    return event.xclient.window;
+    case Expose:           return event.xexpose.window;
+    case EnterNotify:      // fallthrough
+    case LeaveNotify:      return event.xcrossing.window;
+    default:               return None;
+    }
 }
 
-void
-XConnection::last_typed_event(XEvent& event, int type)
-{
-    while (typed_event(event, type));
+XConnection::EventClass
+XConnection::event_class(XEvent const& event)
+{
+    switch (event.type) {
+    case KeyPress:       // fallthrough
+    case KeyRelease:     // fallthrough
+    case ButtonPress:    // fallthrough
+    case ButtonRelease:  // fallthrough
+    case MotionNotify:   // fallthrough
+    case MappingNotify:  return EventClass::Input;
+    case MapRequest:     // fallthrough
+    case MapNotify:      // fallthrough
+    case UnmapNotify:    // fallthrough
+    case DestroyNotify:  // fallthrough
+    case ReparentNotify: // fallthrough
+    case EnterNotify:    // fallthrough
+    case LeaveNotify:    // fallthrough
+    case FocusIn:        // fallthrough
+    case FocusOut:       // fallthrough
+    case ClientMessage:  return EventClass::Structural;
+    default:             return EventClass::Background;
+    }
 }
 
 void
 XConnection::sync(bool discard)
 {
+    report_round_trip("Sync");
     XSync(mp_dpy, discard);
 }
 
@@ -1769,245 +2853,365 @@ XConnection::create_handle()
 
 
 Atom
-XConnection::get_atom(std::string const& name)
+XConnection::get_netwm_atom(NetWMID const& id)
 {
-    if (m_interned_atoms.count(name) > 0)
-        return m_interned_atoms.at(name);
+    if (id >= 0 && id < NetWMID::AtomLast)
+        return m_netwm_atoms[id];
 
-    Atom atom = XInternAtom(mp_dpy, name.c_str(), False);
-    intern_atom(name, atom);
-    return atom;
+    return None;
 }
 
-Atom
-XConnection::get_netwm_atom(NetWMID const& id)
+winsys::Key
+XConnection::get_key(const std::size_t keycode)
+{
+    if (keycode < m_keys.size())
+        return m_keys[keycode];
+
+    return winsys::Key::Any;
+}
+
+std::size_t
+XConnection::get_keycode(const winsys::Key key)
+{
+    return m_keycodes[static_cast<std::size_t>(key)];
+}
+
+KeySym
+XConnection::get_keysym(const winsys::Key key) const
+{
+    switch (key) {
+    case winsys::Key::BackSpace:        return XK_BackSpace;
+    case winsys::Key::Tab:              return XK_Tab;
+    case winsys::Key::Clear:            return XK_Clear;
+    case winsys::Key::Return:           return XK_Return;
+    case winsys::Key::Shift:            return XK_Shift_L;
+    case winsys::Key::Control:          return XK_Control_L;
+    case winsys::Key::Alt:              return XK_Alt_L;
+    case winsys::Key::Super:            return XK_Super_L;
+    case winsys::Key::Menu:             return XK_Menu;
+    case winsys::Key::Pause:            return XK_Pause;
+    case winsys::Key::CapsLock:         return XK_Caps_Lock;
+    case winsys::Key::Escape:           return XK_Escape;
+    case winsys::Key::Space:            return XK_space;
+    case winsys::Key::ExclamationMark:  return XK_exclam;
+    case winsys::Key::QuotationMark:    return XK_quotedbl;
+    case winsys::Key::QuestionMark:     return XK_question;
+    case winsys::Key::NumberSign:       return XK_numbersign;
+    case winsys::Key::DollarSign:       return XK_dollar;
+    case winsys::Key::PercentSign:      return XK_percent;
+    case winsys::Key::AtSign:           return XK_at;
+    case winsys::Key::Ampersand:        return XK_ampersand;
+    case winsys::Key::Apostrophe:       return XK_apostrophe;
+    case winsys::Key::LeftParenthesis:  return XK_parenleft;
+    case winsys::Key::RightParenthesis: return XK_parenright;
+    case winsys::Key::LeftBracket:      return XK_bracketleft;
+    case winsys::Key::RightBracket:     return XK_bracketright;
+    case winsys::Key::LeftBrace:        return XK_braceleft;
+    case winsys::Key::RightBrace:       return XK_braceright;
+    case winsys::Key::Underscore:       return XK_underscore;
+    case winsys::Key::Grave:            return XK_grave;
+    case winsys::Key::Bar:              return XK_bar;
+    case winsys::Key::Tilde:            return XK_asciitilde;
+    case winsys::Key::QuoteLeft:        return XK_quoteleft;
+    case winsys::Key::Asterisk:         return XK_asterisk;
+    case winsys::Key::Plus:             return XK_plus;
+    case winsys::Key::Comma:            return XK_comma;
+    case winsys::Key::Minus:            return XK_minus;
+    case winsys::Key::Period:           return XK_period;
+    case winsys::Key::Slash:            return XK_slash;
+    case winsys::Key::BackSlash:        return XK_backslash;
+    case winsys::Key::Colon:            return XK_colon;
+    case winsys::Key::SemiColon:        return XK_semicolon;
+    case winsys::Key::Less:             return XK_less;
+    case winsys::Key::Equal:            return XK_equal;
+    case winsys::Key::Greater:          return XK_greater;
+    case winsys::Key::PageUp:           return XK_Prior;
+    case winsys::Key::PageDown:         return XK_Next;
+    case winsys::Key::End:              return XK_End;
+    case winsys::Key::Home:             return XK_Home;
+    case winsys::Key::Left:             return XK_Left;
+    case winsys::Key::Up:               return XK_Up;
+    case winsys::Key::Right:            return XK_Right;
+    case winsys::Key::Down:             return XK_Down;
+    case winsys::Key::Select:           return XK_Select;
+    case winsys::Key::Print:            return XK_Print;
+    case winsys::Key::Execute:          return XK_Execute;
+    case winsys::Key::PrintScreen:      return XK_Print;
+    case winsys::Key::Insert:           return XK_Insert;
+    case winsys::Key::Delete:           return XK_Delete;
+    case winsys::Key::Help:             return XK_Help;
+    case winsys::Key::Zero:             return XK_0;
+    case winsys::Key::One:              return XK_1;
+    case winsys::Key::Two:              return XK_2;
+    case winsys::Key::Three:            return XK_3;
+    case winsys::Key::Four:             return XK_4;
+    case winsys::Key::Five:             return XK_5;
+    case winsys::Key::Six:              return XK_6;
+    case winsys::Key::Seven:            return XK_7;
+    case winsys::Key::Eight:            return XK_8;
+    case winsys::Key::Nine:             return XK_9;
+    case winsys::Key::A:                return XK_a;
+    case winsys::Key::B:                return XK_b;
+    case winsys::Key::C:                return XK_c;
+    case winsys::Key::D:                return XK_d;
+    case winsys::Key::E:                return XK_e;
+    case winsys::Key::F:                return XK_f;
+    case winsys::Key::G:                return XK_g;
+    case winsys::Key::H:                return XK_h;
+    case winsys::Key::I:                return XK_i;
+    case winsys::Key::J:                return XK_j;
+    case winsys::Key::K:                return XK_k;
+    case winsys::Key::L:                return XK_l;
+    case winsys::Key::M:                return XK_m;
+    case winsys::Key::N:                return XK_n;
+    case winsys::Key::O:                return XK_o;
+    case winsys::Key::P:                return XK_p;
+    case winsys::Key::Q:                return XK_q;
+    case winsys::Key::R:                return XK_r;
+    case winsys::Key::S:                return XK_s;
+    case winsys::Key::T:                return XK_t;
+    case winsys::Key::U:                return XK_u;
+    case winsys::Key::V:                return XK_v;
+    case winsys::Key::W:                return XK_w;
+    case winsys::Key::X:                return XK_x;
+    case winsys::Key::Y:                return XK_y;
+    case winsys::Key::Z:                return XK_z;
+    case winsys::Key::NumPad0:          return XK_KP_0;
+    case winsys::Key::NumPad1:          return XK_KP_1;
+    case winsys::Key::NumPad2:          return XK_KP_2;
+    case winsys::Key::NumPad3:          return XK_KP_3;
+    case winsys::Key::NumPad4:          return XK_KP_4;
+    case winsys::Key::NumPad5:          return XK_KP_5;
+    case winsys::Key::NumPad6:          return XK_KP_6;
+    case winsys::Key::NumPad7:          return XK_KP_7;
+    case winsys::Key::NumPad8:          return XK_KP_8;
+    case winsys::Key::NumPad9:          return XK_KP_9;
+    case winsys::Key::Multiply:         return XK_KP_Multiply;
+    case winsys::Key::Add:              return XK_KP_Add;
+    case winsys::Key::Seperator:        return XK_KP_Separator;
+    case winsys::Key::Subtract:         return XK_KP_Subtract;
+    case winsys::Key::Decimal:          return XK_KP_Decimal;
+    case winsys::Key::Divide:           return XK_KP_Divide;
+    case winsys::Key::F1:               return XK_F1;
+    case winsys::Key::F2:               return XK_F2;
+    case winsys::Key::F3:               return XK_F3;
+    case winsys::Key::F4:               return XK_F4;
+    case winsys::Key::F5:               return XK_F5;
+    case winsys::Key::F6:               return XK_F6;
+    case winsys::Key::F7:               return XK_F7;
+    case winsys::Key::F8:               return XK_F8;
+    case winsys::Key::F9:               return XK_F9;
+    case winsys::Key::F10:              return XK_F10;
+    case winsys::Key::F11:              return XK_F11;
+    case winsys::Key::F12:              return XK_F12;
+    case winsys::Key::F13:              return XK_F13;
+    case winsys::Key::F14:              return XK_F14;
+    case winsys::Key::F15:              return XK_F15;
+    case winsys::Key::F16:              return XK_F16;
+    case winsys::Key::F17:              return XK_F17;
+    case winsys::Key::F18:              return XK_F18;
+    case winsys::Key::F19:              return XK_F19;
+    case winsys::Key::F20:              return XK_F20;
+    case winsys::Key::F21:              return XK_F21;
+    case winsys::Key::F22:              return XK_F22;
+    case winsys::Key::F23:              return XK_F23;
+    case winsys::Key::F24:              return XK_F24;
+    case winsys::Key::Numlock:          return XK_Num_Lock;
+    case winsys::Key::ScrollLock:       return XK_Scroll_Lock;
+    case winsys::Key::LeftShift:        return XK_Shift_L;
+    case winsys::Key::RightShift:       return XK_Shift_R;
+    case winsys::Key::LeftControl:      return XK_Control_L;
+    case winsys::Key::RightContol:      return XK_Control_R;
+    case winsys::Key::LeftAlt:          return XK_Alt_L;
+    case winsys::Key::RightAlt:         return XK_Alt_R;
+    case winsys::Key::LeftSuper:        return XK_Super_L;
+    case winsys::Key::RightSuper:       return XK_Super_R;
+    case winsys::Key::BrowserBack:      return XF86XK_Back;
+    case winsys::Key::BrowserForward:   return XF86XK_Forward;
+    case winsys::Key::BrowserRefresh:   return XF86XK_Refresh;
+    case winsys::Key::BrowserStop:      return XF86XK_Close;
+    case winsys::Key::BrowserSearch:    return XF86XK_Search;
+    case winsys::Key::BrowserFavorites: return XF86XK_Favorites;
+    case winsys::Key::BrowserHome:      return XF86XK_HomePage;
+    case winsys::Key::VolumeMute:       return XF86XK_AudioMute;
+    case winsys::Key::VolumeDown:       return XF86XK_AudioLowerVolume;
+    case winsys::Key::VolumeUp:         return XF86XK_AudioRaiseVolume;
+    case winsys::Key::MicMute:          return XF86XK_AudioMicMute;
+    case winsys::Key::NextTrack:        return XF86XK_AudioNext;
+    case winsys::Key::PreviousTrack:    return XF86XK_AudioPrev;
+    case winsys::Key::StopMedia:        return XF86XK_AudioStop;
+    case winsys::Key::PlayPause:        return XF86XK_AudioPlay;
+    case winsys::Key::LaunchMail:       return XF86XK_Mail;
+    case winsys::Key::SelectMedia:      return XF86XK_AudioMedia;
+    case winsys::Key::LaunchAppA:       return XF86XK_LaunchA;
+    case winsys::Key::LaunchAppB:       return XF86XK_LaunchB;
+    case winsys::Key::LaunchAppC:       return XF86XK_LaunchC;
+    case winsys::Key::LaunchAppD:       return XF86XK_LaunchD;
+    case winsys::Key::LaunchAppE:       return XF86XK_LaunchE;
+    case winsys::Key::LaunchAppF:       return XF86XK_LaunchF;
+    case winsys::Key::LaunchApp0:       return XF86XK_Launch0;
+    case winsys::Key::LaunchApp1:       return XF86XK_Launch1;
+    case winsys::Key::LaunchApp2:       return XF86XK_Launch2;
+    case winsys::Key::LaunchApp3:       return XF86XK_Launch3;
+    case winsys::Key::LaunchApp4:       return XF86XK_Launch4;
+    case winsys::Key::LaunchApp5:       return XF86XK_Launch5;
+    case winsys::Key::LaunchApp6:       return XF86XK_Launch6;
+    case winsys::Key::LaunchApp7:       return XF86XK_Launch7;
+    case winsys::Key::LaunchApp8:       return XF86XK_Launch8;
+    case winsys::Key::LaunchApp9:       return XF86XK_Launch9;
+    case winsys::Key::BrightnessDown:   return XKB_KEY_XF86MonBrightnessDown;
+    case winsys::Key::BrightnessUp:     return XKB_KEY_XF86MonBrightnessUp;
+    case winsys::Key::KeyboardBrightnessDown: return XKB_KEY_XF86KbdBrightnessDown;
+    case winsys::Key::KeyboardBrightnessUp:   return XKB_KEY_XF86KbdBrightnessUp;
+    case winsys::Key::Any: return NoSymbol;
+    }
+
+    return NoSymbol;
+}
+
+void
+XConnection::load_keyboard_mapping()
 {
-    if (m_netwm_atoms.count(id) > 0)
-        return m_netwm_atoms.at(id);
+    int min_keycode, max_keycode;
+    XDisplayKeycodes(mp_dpy, &min_keycode, &max_keycode);
+
+    int keysyms_per_keycode = 0;
+
+    report_round_trip("GetKeyboardMapping");
+    KeySym* keysyms = XGetKeyboardMapping(
+        mp_dpy,
+        min_keycode,
+        max_keycode - min_keycode + 1,
+        &keysyms_per_keycode
+    );
+
+    if (!keysyms) {
+        spdlog::warn("unable to retrieve keyboard mapping");
+        return;
+    }
 
-    return NetWMID::NetLast;
+    m_min_keycode = min_keycode;
+    m_keysyms_per_keycode = keysyms_per_keycode;
+    m_keyboard_mapping.assign(
+        keysyms,
+        keysyms + (max_keycode - min_keycode + 1) * keysyms_per_keycode
+    );
+
+    XFree(keysyms);
+    index_keys();
 }
 
 void
-XConnection::intern_atom(std::string const& name, Atom atom)
+XConnection::update_keyboard_mapping(int first_keycode, int count)
 {
-    m_interned_atoms[name] = atom;
-    m_atom_names[atom] = name;
+    int keysyms_per_keycode = 0;
+
+    report_round_trip("GetKeyboardMapping");
+    KeySym* keysyms = XGetKeyboardMapping(
+        mp_dpy,
+        first_keycode,
+        count,
+        &keysyms_per_keycode
+    );
+
+    if (!keysyms)
+        return;
+
+    std::size_t offset
+        = (first_keycode - m_min_keycode) * m_keysyms_per_keycode;
+    std::size_t size = count * keysyms_per_keycode;
+
+    // the keycode range or the number of keysyms per keycode changed, the
+    // mapping has to be reloaded as a whole
+    if (keysyms_per_keycode != m_keysyms_per_keycode
+        || first_keycode < m_min_keycode
+        || offset + size > m_keyboard_mapping.size())
+    {
+        XFree(keysyms);
+        load_keyboard_mapping();
+        return;
+    }
+
+    std::copy(keysyms, keysyms + size, m_keyboard_mapping.begin() + offset);
+
+    XFree(keysyms);
+    index_keys();
 }
 
-winsys::Key
-XConnection::get_key(const std::size_t keycode)
+void
+XConnection::index_keys()
 {
-    if (m_keys.count(keycode) > 0)
-        return m_keys.at(keycode);
+    static std::unordered_map<KeySym, KeyCode> keycodes;
+    keycodes.clear();
 
-    return winsys::Key::Any;
+    // as with XKeysymToKeycode, a keysym resolves to the first keycode it is
+    // found at, searching the columns of the mapping in order
+    std::size_t keycode_count = m_keysyms_per_keycode
+        ? m_keyboard_mapping.size() / m_keysyms_per_keycode
+        : 0;
+
+    for (int column = 0; column < m_keysyms_per_keycode; ++column)
+        for (std::size_t i = 0; i < keycode_count; ++i) {
+            KeySym keysym = m_keyboard_mapping[i * m_keysyms_per_keycode + column];
+
+            if (keysym != NoSymbol)
+                keycodes.try_emplace(keysym, static_cast<KeyCode>(m_min_keycode + i));
+        }
+
+    m_keys.fill(winsys::Key::Any);
+
+    for (std::size_t i = 0; i < winsys::KEY_COUNT; ++i) {
+        winsys::Key key = static_cast<winsys::Key>(i);
+        auto keycode = keycodes.find(get_keysym(key));
+
+        if (key == winsys::Key::Any || keycode == keycodes.end()) {
+            m_keycodes[i] = 0;
+            continue;
+        }
+
+        m_keycodes[i] = keycode->second;
+        m_keys[keycode->second] = key;
+    }
 }
 
-std::size_t
-XConnection::get_keycode(const winsys::Key key)
+void
+XConnection::grab_key(KeyCode keycode, unsigned modifiers)
 {
-    if (m_keycodes.count(key) > 0)
-        return m_keycodes.at(key);
+    static const unsigned modifiers_to_ignore[] = {
+        0,
+        Mod2Mask,
+        Mod5Mask
+    };
 
-    unsigned keycode = 0;
+    // keycode zero is AnyKey, which would grab the entire keyboard
+    if (keycode == 0)
+        return;
 
-    switch (key) {
-    case winsys::Key::BackSpace:        keycode = XKeysymToKeycode(mp_dpy, XK_BackSpace);            break;
-    case winsys::Key::Tab:              keycode = XKeysymToKeycode(mp_dpy, XK_Tab);                  break;
-    case winsys::Key::Clear:            keycode = XKeysymToKeycode(mp_dpy, XK_Clear);                break;
-    case winsys::Key::Return:           keycode = XKeysymToKeycode(mp_dpy, XK_Return);               break;
-    case winsys::Key::Shift:            keycode = XKeysymToKeycode(mp_dpy, XK_Shift_L);              break;
-    case winsys::Key::Control:          keycode = XKeysymToKeycode(mp_dpy, XK_Control_L);            break;
-    case winsys::Key::Alt:              keycode = XKeysymToKeycode(mp_dpy, XK_Alt_L);                break;
-    case winsys::Key::Super:            keycode = XKeysymToKeycode(mp_dpy, XK_Super_L);              break;
-    case winsys::Key::Menu:             keycode = XKeysymToKeycode(mp_dpy, XK_Menu);                 break;
-    case winsys::Key::Pause:            keycode = XKeysymToKeycode(mp_dpy, XK_Pause);                break;
-    case winsys::Key::CapsLock:         keycode = XKeysymToKeycode(mp_dpy, XK_Caps_Lock);            break;
-    case winsys::Key::Escape:           keycode = XKeysymToKeycode(mp_dpy, XK_Escape);               break;
-    case winsys::Key::Space:            keycode = XKeysymToKeycode(mp_dpy, XK_space);                break;
-    case winsys::Key::ExclamationMark:  keycode = XKeysymToKeycode(mp_dpy, XK_exclam);               break;
-    case winsys::Key::QuotationMark:    keycode = XKeysymToKeycode(mp_dpy, XK_quotedbl);             break;
-    case winsys::Key::QuestionMark:     keycode = XKeysymToKeycode(mp_dpy, XK_question);             break;
-    case winsys::Key::NumberSign:       keycode = XKeysymToKeycode(mp_dpy, XK_numbersign);           break;
-    case winsys::Key::DollarSign:       keycode = XKeysymToKeycode(mp_dpy, XK_dollar);               break;
-    case winsys::Key::PercentSign:      keycode = XKeysymToKeycode(mp_dpy, XK_percent);              break;
-    case winsys::Key::AtSign:           keycode = XKeysymToKeycode(mp_dpy, XK_at);                   break;
-    case winsys::Key::Ampersand:        keycode = XKeysymToKeycode(mp_dpy, XK_ampersand);            break;
-    case winsys::Key::Apostrophe:       keycode = XKeysymToKeycode(mp_dpy, XK_apostrophe);           break;
-    case winsys::Key::LeftParenthesis:  keycode = XKeysymToKeycode(mp_dpy, XK_parenleft);            break;
-    case winsys::Key::RightParenthesis: keycode = XKeysymToKeycode(mp_dpy, XK_parenright);           break;
-    case winsys::Key::LeftBracket:      keycode = XKeysymToKeycode(mp_dpy, XK_bracketleft);          break;
-    case winsys::Key::RightBracket:     keycode = XKeysymToKeycode(mp_dpy, XK_bracketright);         break;
-    case winsys::Key::LeftBrace:        keycode = XKeysymToKeycode(mp_dpy, XK_braceleft);            break;
-    case winsys::Key::RightBrace:       keycode = XKeysymToKeycode(mp_dpy, XK_braceright);           break;
-    case winsys::Key::Underscore:       keycode = XKeysymToKeycode(mp_dpy, XK_underscore);           break;
-    case winsys::Key::Grave:            keycode = XKeysymToKeycode(mp_dpy, XK_grave);                break;
-    case winsys::Key::Bar:              keycode = XKeysymToKeycode(mp_dpy, XK_bar);                  break;
-    case winsys::Key::Tilde:            keycode = XKeysymToKeycode(mp_dpy, XK_asciitilde);           break;
-    case winsys::Key::QuoteLeft:        keycode = XKeysymToKeycode(mp_dpy, XK_quoteleft);            break;
-    case winsys::Key::Asterisk:         keycode = XKeysymToKeycode(mp_dpy, XK_asterisk);             break;
-    case winsys::Key::Plus:             keycode = XKeysymToKeycode(mp_dpy, XK_plus);                 break;
-    case winsys::Key::Comma:            keycode = XKeysymToKeycode(mp_dpy, XK_comma);                break;
-    case winsys::Key::Minus:            keycode = XKeysymToKeycode(mp_dpy, XK_minus);                break;
-    case winsys::Key::Period:           keycode = XKeysymToKeycode(mp_dpy, XK_period);               break;
-    case winsys::Key::Slash:            keycode = XKeysymToKeycode(mp_dpy, XK_slash);                break;
-    case winsys::Key::BackSlash:        keycode = XKeysymToKeycode(mp_dpy, XK_backslash);            break;
-    case winsys::Key::Colon:            keycode = XKeysymToKeycode(mp_dpy, XK_colon);                break;
-    case winsys::Key::SemiColon:        keycode = XKeysymToKeycode(mp_dpy, XK_semicolon);            break;
-    case winsys::Key::Less:             keycode = XKeysymToKeycode(mp_dpy, XK_less);                 break;
-    case winsys::Key::Equal:            keycode = XKeysymToKeycode(mp_dpy, XK_equal);                break;
-    case winsys::Key::Greater:          keycode = XKeysymToKeycode(mp_dpy, XK_greater);              break;
-    case winsys::Key::PageUp:           keycode = XKeysymToKeycode(mp_dpy, XK_Prior);                break;
-    case winsys::Key::PageDown:         keycode = XKeysymToKeycode(mp_dpy, XK_Next);                 break;
-    case winsys::Key::End:              keycode = XKeysymToKeycode(mp_dpy, XK_End);                  break;
-    case winsys::Key::Home:             keycode = XKeysymToKeycode(mp_dpy, XK_Home);                 break;
-    case winsys::Key::Left:             keycode = XKeysymToKeycode(mp_dpy, XK_Left);                 break;
-    case winsys::Key::Up:               keycode = XKeysymToKeycode(mp_dpy, XK_Up);                   break;
-    case winsys::Key::Right:            keycode = XKeysymToKeycode(mp_dpy, XK_Right);                break;
-    case winsys::Key::Down:             keycode = XKeysymToKeycode(mp_dpy, XK_Down);                 break;
-    case winsys::Key::Select:           keycode = XKeysymToKeycode(mp_dpy, XK_Select);               break;
-    case winsys::Key::Print:            keycode = XKeysymToKeycode(mp_dpy, XK_Print);                break;
-    case winsys::Key::Execute:          keycode = XKeysymToKeycode(mp_dpy, XK_Execute);              break;
-    case winsys::Key::PrintScreen:      keycode = XKeysymToKeycode(mp_dpy, XK_Print);                break;
-    case winsys::Key::Insert:           keycode = XKeysymToKeycode(mp_dpy, XK_Insert);               break;
-    case winsys::Key::Delete:           keycode = XKeysymToKeycode(mp_dpy, XK_Delete);               break;
-    case winsys::Key::Help:             keycode = XKeysymToKeycode(mp_dpy, XK_Help);                 break;
-    case winsys::Key::Zero:             keycode = XKeysymToKeycode(mp_dpy, XK_0);                    break;
-    case winsys::Key::One:              keycode = XKeysymToKeycode(mp_dpy, XK_1);                    break;
-    case winsys::Key::Two:              keycode = XKeysymToKeycode(mp_dpy, XK_2);                    break;
-    case winsys::Key::Three:            keycode = XKeysymToKeycode(mp_dpy, XK_3);                    break;
-    case winsys::Key::Four:             keycode = XKeysymToKeycode(mp_dpy, XK_4);                    break;
-    case winsys::Key::Five:             keycode = XKeysymToKeycode(mp_dpy, XK_5);                    break;
-    case winsys::Key::Six:              keycode = XKeysymToKeycode(mp_dpy, XK_6);                    break;
-    case winsys::Key::Seven:            keycode = XKeysymToKeycode(mp_dpy, XK_7);                    break;
-    case winsys::Key::Eight:            keycode = XKeysymToKeycode(mp_dpy, XK_8);                    break;
-    case winsys::Key::Nine:             keycode = XKeysymToKeycode(mp_dpy, XK_9);                    break;
-    case winsys::Key::A:                keycode = XKeysymToKeycode(mp_dpy, XK_a);                    break;
-    case winsys::Key::B:                keycode = XKeysymToKeycode(mp_dpy, XK_b);                    break;
-    case winsys::Key::C:                keycode = XKeysymToKeycode(mp_dpy, XK_c);                    break;
-    case winsys::Key::D:                keycode = XKeysymToKeycode(mp_dpy, XK_d);                    break;
-    case winsys::Key::E:                keycode = XKeysymToKeycode(mp_dpy, XK_e);                    break;
-    case winsys::Key::F:                keycode = XKeysymToKeycode(mp_dpy, XK_f);                    break;
-    case winsys::Key::G:                keycode = XKeysymToKeycode(mp_dpy, XK_g);                    break;
-    case winsys::Key::H:                keycode = XKeysymToKeycode(mp_dpy, XK_h);                    break;
-    case winsys::Key::I:                keycode = XKeysymToKeycode(mp_dpy, XK_i);                    break;
-    case winsys::Key::J:                keycode = XKeysymToKeycode(mp_dpy, XK_j);                    break;
-    case winsys::Key::K:                keycode = XKeysymToKeycode(mp_dpy, XK_k);                    break;
-    case winsys::Key::L:                keycode = XKeysymToKeycode(mp_dpy, XK_l);                    break;
-    case winsys::Key::M:                keycode = XKeysymToKeycode(mp_dpy, XK_m);                    break;
-    case winsys::Key::N:                keycode = XKeysymToKeycode(mp_dpy, XK_n);                    break;
-    case winsys::Key::O:                keycode = XKeysymToKeycode(mp_dpy, XK_o);                    break;
-    case winsys::Key::P:                keycode = XKeysymToKeycode(mp_dpy, XK_p);                    break;
-    case winsys::Key::Q:                keycode = XKeysymToKeycode(mp_dpy, XK_q);                    break;
-    case winsys::Key::R:                keycode = XKeysymToKeycode(mp_dpy, XK_r);                    break;
-    case winsys::Key::S:                keycode = XKeysymToKeycode(mp_dpy, XK_s);                    break;
-    case winsys::Key::T:                keycode = XKeysymToKeycode(mp_dpy, XK_t);                    break;
-    case winsys::Key::U:                keycode = XKeysymToKeycode(mp_dpy, XK_u);                    break;
-    case winsys::Key::V:                keycode = XKeysymToKeycode(mp_dpy, XK_v);                    break;
-    case winsys::Key::W:                keycode = XKeysymToKeycode(mp_dpy, XK_w);                    break;
-    case winsys::Key::X:                keycode = XKeysymToKeycode(mp_dpy, XK_x);                    break;
-    case winsys::Key::Y:                keycode = XKeysymToKeycode(mp_dpy, XK_y);                    break;
-    case winsys::Key::Z:                keycode = XKeysymToKeycode(mp_dpy, XK_z);                    break;
-    case winsys::Key::NumPad0:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_0);                 break;
-    case winsys::Key::NumPad1:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_1);                 break;
-    case winsys::Key::NumPad2:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_2);                 break;
-    case winsys::Key::NumPad3:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_3);                 break;
-    case winsys::Key::NumPad4:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_4);                 break;
-    case winsys::Key::NumPad5:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_5);                 break;
-    case winsys::Key::NumPad6:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_6);                 break;
-    case winsys::Key::NumPad7:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_7);                 break;
-    case winsys::Key::NumPad8:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_8);                 break;
-    case winsys::Key::NumPad9:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_9);                 break;
-    case winsys::Key::Multiply:         keycode = XKeysymToKeycode(mp_dpy, XK_KP_Multiply);          break;
-    case winsys::Key::Add:              keycode = XKeysymToKeycode(mp_dpy, XK_KP_Add);               break;
-    case winsys::Key::Seperator:        keycode = XKeysymToKeycode(mp_dpy, XK_KP_Separator);         break;
-    case winsys::Key::Subtract:         keycode = XKeysymToKeycode(mp_dpy, XK_KP_Subtract);          break;
-    case winsys::Key::Decimal:          keycode = XKeysymToKeycode(mp_dpy, XK_KP_Decimal);           break;
-    case winsys::Key::Divide:           keycode = XKeysymToKeycode(mp_dpy, XK_KP_Divide);            break;
-    case winsys::Key::F1:               keycode = XKeysymToKeycode(mp_dpy, XK_F1);                   break;
-    case winsys::Key::F2:               keycode = XKeysymToKeycode(mp_dpy, XK_F2);                   break;
-    case winsys::Key::F3:               keycode = XKeysymToKeycode(mp_dpy, XK_F3);                   break;
-    case winsys::Key::F4:               keycode = XKeysymToKeycode(mp_dpy, XK_F4);                   break;
-    case winsys::Key::F5:               keycode = XKeysymToKeycode(mp_dpy, XK_F5);                   break;
-    case winsys::Key::F6:               keycode = XKeysymToKeycode(mp_dpy, XK_F6);                   break;
-    case winsys::Key::F7:               keycode = XKeysymToKeycode(mp_dpy, XK_F7);                   break;
-    case winsys::Key::F8:               keycode = XKeysymToKeycode(mp_dpy, XK_F8);                   break;
-    case winsys::Key::F9:               keycode = XKeysymToKeycode(mp_dpy, XK_F9);                   break;
-    case winsys::Key::F10:              keycode = XKeysymToKeycode(mp_dpy, XK_F10);                  break;
-    case winsys::Key::F11:              keycode = XKeysymToKeycode(mp_dpy, XK_F11);                  break;
-    case winsys::Key::F12:              keycode = XKeysymToKeycode(mp_dpy, XK_F12);                  break;
-    case winsys::Key::F13:              keycode = XKeysymToKeycode(mp_dpy, XK_F13);                  break;
-    case winsys::Key::F14:              keycode = XKeysymToKeycode(mp_dpy, XK_F14);                  break;
-    case winsys::Key::F15:              keycode = XKeysymToKeycode(mp_dpy, XK_F15);                  break;
-    case winsys::Key::F16:              keycode = XKeysymToKeycode(mp_dpy, XK_F16);                  break;
-    case winsys::Key::F17:              keycode = XKeysymToKeycode(mp_dpy, XK_F17);                  break;
-    case winsys::Key::F18:              keycode = XKeysymToKeycode(mp_dpy, XK_F18);                  break;
-    case winsys::Key::F19:              keycode = XKeysymToKeycode(mp_dpy, XK_F19);                  break;
-    case winsys::Key::F20:              keycode = XKeysymToKeycode(mp_dpy, XK_F20);                  break;
-    case winsys::Key::F21:              keycode = XKeysymToKeycode(mp_dpy, XK_F21);                  break;
-    case winsys::Key::F22:              keycode = XKeysymToKeycode(mp_dpy, XK_F22);                  break;
-    case winsys::Key::F23:              keycode = XKeysymToKeycode(mp_dpy, XK_F23);                  break;
-    case winsys::Key::F24:              keycode = XKeysymToKeycode(mp_dpy, XK_F24);                  break;
-    case winsys::Key::Numlock:          keycode = XKeysymToKeycode(mp_dpy, XK_Num_Lock);             break;
-    case winsys::Key::ScrollLock:       keycode = XKeysymToKeycode(mp_dpy, XK_Scroll_Lock);          break;
-    case winsys::Key::LeftShift:        keycode = XKeysymToKeycode(mp_dpy, XK_Shift_L);              break;
-    case winsys::Key::RightShift:       keycode = XKeysymToKeycode(mp_dpy, XK_Shift_R);              break;
-    case winsys::Key::LeftControl:      keycode = XKeysymToKeycode(mp_dpy, XK_Control_L);            break;
-    case winsys::Key::RightContol:      keycode = XKeysymToKeycode(mp_dpy, XK_Control_R);            break;
-    case winsys::Key::LeftAlt:          keycode = XKeysymToKeycode(mp_dpy, XK_Alt_L);                break;
-    case winsys::Key::RightAlt:         keycode = XKeysymToKeycode(mp_dpy, XK_Alt_R);                break;
-    case winsys::Key::LeftSuper:        keycode = XKeysymToKeycode(mp_dpy, XK_Super_L);              break;
-    case winsys::Key::RightSuper:       keycode = XKeysymToKeycode(mp_dpy, XK_Super_R);              break;
-    case winsys::Key::BrowserBack:      keycode = XKeysymToKeycode(mp_dpy, XF86XK_Back);             break;
-    case winsys::Key::BrowserForward:   keycode = XKeysymToKeycode(mp_dpy, XF86XK_Forward);          break;
-    case winsys::Key::BrowserRefresh:   keycode = XKeysymToKeycode(mp_dpy, XF86XK_Refresh);          break;
-    case winsys::Key::BrowserStop:      keycode = XKeysymToKeycode(mp_dpy, XF86XK_Close);            break;
-    case winsys::Key::BrowserSearch:    keycode = XKeysymToKeycode(mp_dpy, XF86XK_Search);           break;
-    case winsys::Key::BrowserFavorites: keycode = XKeysymToKeycode(mp_dpy, XF86XK_Favorites);        break;
-    case winsys::Key::BrowserHome:      keycode = XKeysymToKeycode(mp_dpy, XF86XK_HomePage);         break;
-    case winsys::Key::VolumeMute:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioMute);        break;
-    case winsys::Key::VolumeDown:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioLowerVolume); break;
-    case winsys::Key::VolumeUp:         keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioRaiseVolume); break;
-    case winsys::Key::MicMute:          keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioMicMute);     break;
-    case winsys::Key::NextTrack:        keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioNext);        break;
-    case winsys::Key::PreviousTrack:    keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioPrev);        break;
-    case winsys::Key::StopMedia:        keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioStop);        break;
-    case winsys::Key::PlayPause:        keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioPlay);        break;
-    case winsys::Key::LaunchMail:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Mail);             break;
-    case winsys::Key::SelectMedia:      keycode = XKeysymToKeycode(mp_dpy, XF86XK_AudioMedia);       break;
-    case winsys::Key::LaunchAppA:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchA);          break;
-    case winsys::Key::LaunchAppB:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchB);          break;
-    case winsys::Key::LaunchAppC:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchC);          break;
-    case winsys::Key::LaunchAppD:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchD);          break;
-    case winsys::Key::LaunchAppE:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchE);          break;
-    case winsys::Key::LaunchAppF:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_LaunchF);          break;
-    case winsys::Key::LaunchApp0:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch0);          break;
-    case winsys::Key::LaunchApp1:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch1);          break;
-    case winsys::Key::LaunchApp2:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch2);          break;
-    case winsys::Key::LaunchApp3:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch3);          break;
-    case winsys::Key::LaunchApp4:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch4);          break;
-    case winsys::Key::LaunchApp5:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch5);          break;
-    case winsys::Key::LaunchApp6:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch6);          break;
-    case winsys::Key::LaunchApp7:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch7);          break;
-    case winsys::Key::LaunchApp8:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch8);          break;
-    case winsys::Key::LaunchApp9:       keycode = XKeysymToKeycode(mp_dpy, XF86XK_Launch9);          break;
-    case winsys::Key::BrightnessDown:   keycode = XKeysymToKeycode(mp_dpy, XKB_KEY_XF86MonBrightnessDown); break;
-    case winsys::Key::BrightnessUp:     keycode = XKeysymToKeycode(mp_dpy, XKB_KEY_XF86MonBrightnessDown); break;
-    case winsys::Key::KeyboardBrightnessDown: keycode = XKeysymToKeycode(mp_dpy, XKB_KEY_XF86KbdBrightnessDown); break;
-    case winsys::Key::KeyboardBrightnessUp:   keycode = XKeysymToKeycode(mp_dpy, XKB_KEY_XF86KbdBrightnessDown); break;
-    case winsys::Key::Any: return 0;
-    }
-
-    intern_key(keycode, key);
-    return keycode;
-}
-
-void
-XConnection::intern_key(const unsigned keycode, const winsys::Key key)
-{
-    m_keys[keycode] = key;
-    m_keycodes[key] = keycode;
+    for (unsigned modifier : modifiers_to_ignore)
+        XGrabKey(mp_dpy,
+            keycode,
+            modifiers | modifier,
+            m_root,
+            True,
+            GrabModeAsync,
+            GrabModeAsync
+        );
+}
+
+void
+XConnection::ungrab_key(KeyCode keycode, unsigned modifiers)
+{
+    static const unsigned modifiers_to_ignore[] = {
+        0,
+        Mod2Mask,
+        Mod5Mask
+    };
+
+    if (keycode == 0)
+        return;
+
+    for (unsigned modifier : modifiers_to_ignore)
+        XUngrabKey(mp_dpy, keycode, modifiers | modifier, m_root);
 }
 
 winsys::Button
@@ -2043,38 +3247,38 @@ XConnection::get_buttoncode(const winsys::Button button) const
 winsys::WindowState
 XConnection::get_window_state_from_atom(Atom atom)
 {
-    if (atom == get_atom("_NET_WM_STATE_MODAL"))             return winsys::WindowState::Modal;
-    if (atom == get_atom("_NET_WM_STATE_STICKY"))            return winsys::WindowState::Sticky;
-    if (atom == get_atom("_NET_WM_STATE_MAXIMIZEDVERT"))     return winsys::WindowState::MaximizedVert;
-    if (atom == get_atom("_NET_WM_STATE_MAXIMIZEDHORZ"))     return winsys::WindowState::MaximizedHorz;
-    if (atom == get_atom("_NET_WM_STATE_SHADED"))            return winsys::WindowState::Shaded;
-    if (atom == get_atom("_NET_WM_STATE_SKIPTASKBAR"))       return winsys::WindowState::SkipTaskbar;
-    if (atom == get_atom("_NET_WM_STATE_SKIPPAGER"))         return winsys::WindowState::SkipPager;
-    if (atom == get_atom("_NET_WM_STATE_HIDDEN"))            return winsys::WindowState::Hidden;
-    if (atom == get_atom("_NET_WM_STATE_FULLSCREEN"))        return winsys::WindowState::Fullscreen;
-    if (atom == get_atom("_NET_WM_STATE_ABOVE"))             return winsys::WindowState::Above_;
-    if (atom == get_atom("_NET_WM_STATE_BELOW"))             return winsys::WindowState::Below_;
-    if (atom == get_atom("_NET_WM_STATE_DEMANDS_ATTENTION")) return winsys::WindowState::DemandsAttention;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateModal))             return winsys::WindowState::Modal;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateSticky))            return winsys::WindowState::Sticky;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateMaximizedVert))     return winsys::WindowState::MaximizedVert;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateMaximizedHorz))     return winsys::WindowState::MaximizedHorz;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateShaded))            return winsys::WindowState::Shaded;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateSkipTaskbar))       return winsys::WindowState::SkipTaskbar;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateSkipPager))         return winsys::WindowState::SkipPager;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateHidden))            return winsys::WindowState::Hidden;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateFullscreen))        return winsys::WindowState::Fullscreen;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateAbove))             return winsys::WindowState::Above_;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateBelow))             return winsys::WindowState::Below_;
+    if (atom == get_netwm_atom(NetWMID::NetWMStateDemandsAttention)) return winsys::WindowState::DemandsAttention;
     return winsys::WindowState::Hidden;
 }
 
 winsys::WindowType
 XConnection::get_window_type_from_atom(Atom atom)
 {
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_DESKTOP"))      return winsys::WindowType::Desktop;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_DOCK"))         return winsys::WindowType::Dock;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_TOOLBAR"))      return winsys::WindowType::Toolbar;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_MENU"))         return winsys::WindowType::Menu;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_UTILITY"))      return winsys::WindowType::Utility;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_SPLASH"))       return winsys::WindowType::Splash;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_DIALOG"))       return winsys::WindowType::Dialog;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_DROPDOWNMENU")) return winsys::WindowType::DropdownMenu;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_POPUPMENU"))    return winsys::WindowType::PopupMenu;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_TOOLTIP"))      return winsys::WindowType::Tooltip;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_NOTIFICATION")) return winsys::WindowType::Notification;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_COMBO"))        return winsys::WindowType::Combo;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_DND"))          return winsys::WindowType::Dnd;
-    if (atom == get_atom("_NET_WM_WINDOW_TYPE_NORMAL"))       return winsys::WindowType::Normal;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeDesktop))      return winsys::WindowType::Desktop;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeDock))         return winsys::WindowType::Dock;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeToolbar))      return winsys::WindowType::Toolbar;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeMenu))         return winsys::WindowType::Menu;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeUtility))      return winsys::WindowType::Utility;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeSplash))       return winsys::WindowType::Splash;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeDialog))       return winsys::WindowType::Dialog;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeDropdownMenu)) return winsys::WindowType::DropdownMenu;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypePopupMenu))    return winsys::WindowType::PopupMenu;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeTooltip))      return winsys::WindowType::Tooltip;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeNotification)) return winsys::WindowType::Notification;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeCombo))        return winsys::WindowType::Combo;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeDnd))          return winsys::WindowType::Dnd;
+    if (atom == get_netwm_atom(NetWMID::NetWMWindowTypeNormal))       return winsys::WindowType::Normal;
     return winsys::WindowType::Normal;
 }
 
@@ -2082,18 +3286,18 @@ Atom
 XConnection::get_atom_from_window_state(winsys::WindowState state)
 {
     switch (state) {
-    case winsys::WindowState::Modal:            return get_atom("_NET_WM_STATE_MODAL");
-    case winsys::WindowState::Sticky:           return get_atom("_NET_WM_STATE_STICKY");
-    case winsys::WindowState::MaximizedVert:    return get_atom("_NET_WM_STATE_MAXIMIZEDVERT");
-    case winsys::WindowState::MaximizedHorz:    return get_atom("_NET_WM_STATE_MAXIMIZEDHORZ");
-    case winsys::WindowState::Shaded:           return get_atom("_NET_WM_STATE_SHADED");
-    case winsys::WindowState::SkipTaskbar:      return get_atom("_NET_WM_STATE_SKIPTASKBAR");
-    case winsys::WindowState::SkipPager:        return get_atom("_NET_WM_STATE_SKIPPAGER");
-    case winsys::WindowState::Hidden:           return get_atom("_NET_WM_STATE_HIDDEN");
-    case winsys::WindowState::Fullscreen:       return get_atom("_NET_WM_STATE_FULLSCREEN");
-    case winsys::WindowState::Above_:           return get_atom("_NET_WM_STATE_ABOVE");
-    case winsys::WindowState::Below_:           return get_atom("_NET_WM_STATE_BELOW");
-    case winsys::WindowState::DemandsAttention: return get_atom("_NET_WM_STATE_DEMANDS_ATTENTION");
+    case winsys::WindowState::Modal:            return get_netwm_atom(NetWMID::NetWMStateModal);
+    case winsys::WindowState::Sticky:           return get_netwm_atom(NetWMID::NetWMStateSticky);
+    case winsys::WindowState::MaximizedVert:    return get_netwm_atom(NetWMID::NetWMStateMaximizedVert);
+    case winsys::WindowState::MaximizedHorz:    return get_netwm_atom(NetWMID::NetWMStateMaximizedHorz);
+    case winsys::WindowState::Shaded:           return get_netwm_atom(NetWMID::NetWMStateShaded);
+    case winsys::WindowState::SkipTaskbar:      return get_netwm_atom(NetWMID::NetWMStateSkipTaskbar);
+    case winsys::WindowState::SkipPager:        return get_netwm_atom(NetWMID::NetWMStateSkipPager);
+    case winsys::WindowState::Hidden:           return get_netwm_atom(NetWMID::NetWMStateHidden);
+    case winsys::WindowState::Fullscreen:       return get_netwm_atom(NetWMID::NetWMStateFullscreen);
+    case winsys::WindowState::Above_:           return get_netwm_atom(NetWMID::NetWMStateAbove);
+    case winsys::WindowState::Below_:           return get_netwm_atom(NetWMID::NetWMStateBelow);
+    case winsys::WindowState::DemandsAttention: return get_netwm_atom(NetWMID::NetWMStateDemandsAttention);
     default: return 0;
     }
 }
@@ -2102,21 +3306,21 @@ Atom
 XConnection::get_atom_from_window_type(winsys::WindowType type)
 {
     switch (type) {
-    case winsys::WindowType::Desktop:      return get_atom("_NET_WM_WINDOW_TYPE_DESKTOP");
-    case winsys::WindowType::Dock:         return get_atom("_NET_WM_WINDOW_TYPE_DOCK");
-    case winsys::WindowType::Toolbar:      return get_atom("_NET_WM_WINDOW_TYPE_TOOLBAR");
-    case winsys::WindowType::Menu:         return get_atom("_NET_WM_WINDOW_TYPE_MENU");
-    case winsys::WindowType::Utility:      return get_atom("_NET_WM_WINDOW_TYPE_UTILITY");
-    case winsys::WindowType::Splash:       return get_atom("_NET_WM_WINDOW_TYPE_SPLASH");
-    case winsys::WindowType::Dialog:       return get_atom("_NET_WM_WINDOW_TYPE_DIALOG");
-    case winsys::WindowType::DropdownMenu: return get_atom("_NET_WM_WINDOW_TYPE_DROPDOWNMENU");
-    case winsys::WindowType::PopupMenu:    return get_atom("_NET_WM_WINDOW_TYPE_POPUPMENU");
-    case winsys::WindowType::Tooltip:      return get_atom("_NET_WM_WINDOW_TYPE_TOOLTIP");
-    case winsys::WindowType::Notification: return get_atom("_NET_WM_WINDOW_TYPE_NOTIFICATION");
-    case winsys::WindowType::Combo:        return get_atom("_NET_WM_WINDOW_TYPE_COMBO");
-    case winsys::WindowType::Dnd:          return get_atom("_NET_WM_WINDOW_TYPE_DND");
-    case winsys::WindowType::Normal:       return get_atom("_NET_WM_WINDOW_TYPE_NORMAL");
-    default: return get_atom("_NET_WM_WINDOW_TYPE_NORMAL");
+    case winsys::WindowType::Desktop:      return get_netwm_atom(NetWMID::NetWMWindowTypeDesktop);
+    case winsys::WindowType::Dock:         return get_netwm_atom(NetWMID::NetWMWindowTypeDock);
+    case winsys::WindowType::Toolbar:      return get_netwm_atom(NetWMID::NetWMWindowTypeToolbar);
+    case winsys::WindowType::Menu:         return get_netwm_atom(NetWMID::NetWMWindowTypeMenu);
+    case winsys::WindowType::Utility:      return get_netwm_atom(NetWMID::NetWMWindowTypeUtility);
+    case winsys::WindowType::Splash:       return get_netwm_atom(NetWMID::NetWMWindowTypeSplash);
+    case winsys::WindowType::Dialog:       return get_netwm_atom(NetWMID::NetWMWindowTypeDialog);
+    case winsys::WindowType::DropdownMenu: return get_netwm_atom(NetWMID::NetWMWindowTypeDropdownMenu);
+    case winsys::WindowType::PopupMenu:    return get_netwm_atom(NetWMID::NetWMWindowTypePopupMenu);
+    case winsys::WindowType::Tooltip:      return get_netwm_atom(NetWMID::NetWMWindowTypeTooltip);
+    case winsys::WindowType::Notification: return get_netwm_atom(NetWMID::NetWMWindowTypeNotification);
+    case winsys::WindowType::Combo:        return get_netwm_atom(NetWMID::NetWMWindowTypeCombo);
+    case winsys::WindowType::Dnd:          return get_netwm_atom(NetWMID::NetWMWindowTypeDnd);
+    case winsys::WindowType::Normal:       return get_netwm_atom(NetWMID::NetWMWindowTypeNormal);
+    default: return get_netwm_atom(NetWMID::NetWMWindowTypeNormal);
     }
 }
 
@@ -2138,6 +3342,7 @@ XConnection::has_atom_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
         0L, 32, False, XA_ATOM,
         &returned_type, &_i, &n_items_returned,
@@ -2149,7 +3354,7 @@ XConnection::has_atom_property(winsys::Window window, Atom atom)
 }
 
 Atom
-XConnection::get_atom_property(winsys::Window window, std::string const& name)
+XConnection::get_atom_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2158,10 +3363,11 @@ XConnection::get_atom_property(winsys::Window window, std::string const& name)
     Atom _a = None;
     Atom atom = None;
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_ATOM,
         &_a, &_i, &n, &_ul,
@@ -2178,12 +3384,12 @@ XConnection::get_atom_property(winsys::Window window, std::string const& name)
 }
 
 void
-XConnection::replace_atom_property(winsys::Window window, std::string const& name, Atom atom)
+XConnection::replace_atom_property(winsys::Window window, NetWMID id, Atom atom)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_ATOM,
         32,
         PropModeReplace,
@@ -2193,12 +3399,12 @@ XConnection::replace_atom_property(winsys::Window window, std::string const& nam
 }
 
 void
-XConnection::unset_atom_property(winsys::Window window, std::string const& name)
+XConnection::unset_atom_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_ATOM,
         32,
         PropModeReplace,
@@ -2216,6 +3422,7 @@ XConnection::has_atomlist_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
         0L, 32, False, XA_ATOM,
         &returned_type, &_i, &n_items_returned,
@@ -2227,7 +3434,7 @@ XConnection::has_atomlist_property(winsys::Window window, Atom atom)
 }
 
 std::vector<Atom>
-XConnection::get_atomlist_property(winsys::Window window, std::string const& name)
+XConnection::get_atomlist_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2236,10 +3443,11 @@ XConnection::get_atomlist_property(winsys::Window window, std::string const& nam
     Atom _a = None;
     std::vector<Atom> atomlist{};
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_ATOM,
         &_a, &_i, &n, &_ul,
@@ -2258,12 +3466,12 @@ XConnection::get_atomlist_property(winsys::Window window, std::string const& nam
 }
 
 void
-XConnection::replace_atomlist_property(winsys::Window window, std::string const& name, std::vector<Atom> const& atomlist)
+XConnection::replace_atomlist_property(winsys::Window window, NetWMID id, std::vector<Atom> const& atomlist)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_ATOM,
         32,
         PropModeReplace,
@@ -2273,12 +3481,12 @@ XConnection::replace_atomlist_property(winsys::Window window, std::string const&
 }
 
 void
-XConnection::append_atomlist_property(winsys::Window window, std::string const& name, Atom atom)
+XConnection::append_atomlist_property(winsys::Window window, NetWMID id, Atom atom)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_ATOM,
         32,
         PropModeAppend,
@@ -2288,12 +3496,12 @@ XConnection::append_atomlist_property(winsys::Window window, std::string const&
 }
 
 void
-XConnection::unset_atomlist_property(winsys::Window window, std::string const& name)
+XConnection::unset_atomlist_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_ATOM,
         32,
         PropModeReplace,
@@ -2311,6 +3519,7 @@ XConnection::has_window_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
         0L, 32, False, XA_WINDOW,
         &returned_type, &_i, &n_items_returned,
@@ -2322,7 +3531,7 @@ XConnection::has_window_property(winsys::Window window, Atom atom)
 }
 
 winsys::Window
-XConnection::get_window_property(winsys::Window window, std::string const& name)
+XConnection::get_window_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2331,10 +3540,11 @@ XConnection::get_window_property(winsys::Window window, std::string const& name)
     Atom _a = None;
     winsys::Window window_ = None;
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_WINDOW,
         &_a, &_i, &n, &_ul,
@@ -2351,12 +3561,12 @@ XConnection::get_window_property(winsys::Window window, std::string const& name)
 }
 
 void
-XConnection::replace_window_property(winsys::Window window, std::string const& name, winsys::Window window_)
+XConnection::replace_window_property(winsys::Window window, NetWMID id, winsys::Window window_)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_WINDOW,
         32,
         PropModeReplace,
@@ -2366,12 +3576,12 @@ XConnection::replace_window_property(winsys::Window window, std::string const& n
 }
 
 void
-XConnection::unset_window_property(winsys::Window window, std::string const& name)
+XConnection::unset_window_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_WINDOW,
         32,
         PropModeReplace,
@@ -2389,6 +3599,7 @@ XConnection::has_windowlist_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
         0L, 32, False, XA_WINDOW,
         &returned_type, &_i, &n_items_returned,
@@ -2400,7 +3611,7 @@ XConnection::has_windowlist_property(winsys::Window window, Atom atom)
 }
 
 std::vector<winsys::Window>
-XConnection::get_windowlist_property(winsys::Window window, std::string const& name)
+XConnection::get_windowlist_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2409,10 +3620,11 @@ XConnection::get_windowlist_property(winsys::Window window, std::string const& n
     Atom _a = None;
     std::vector<winsys::Window> windowlist{};
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_WINDOW,
         &_a, &_i, &n, &_ul,
@@ -2431,12 +3643,12 @@ XConnection::get_windowlist_property(winsys::Window window, std::string const& n
 }
 
 void
-XConnection::replace_windowlist_property(winsys::Window window, std::string const& name, std::vector<winsys::Window> const& windowlist)
+XConnection::replace_windowlist_property(winsys::Window window, NetWMID id, std::vector<winsys::Window> const& windowlist)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_WINDOW,
         32,
         PropModeReplace,
@@ -2446,12 +3658,12 @@ XConnection::replace_windowlist_property(winsys::Window window, std::string cons
 }
 
 void
-XConnection::append_windowlist_property(winsys::Window window, std::string const& name, winsys::Window window_)
+XConnection::append_windowlist_property(winsys::Window window, NetWMID id, winsys::Window window_)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_WINDOW,
         32,
         PropModeAppend,
@@ -2461,12 +3673,41 @@ XConnection::append_windowlist_property(winsys::Window window, std::string const
 }
 
 void
-XConnection::unset_windowlist_property(winsys::Window window, std::string const& name)
+XConnection::update_windowlist_property(
+    winsys::Window window,
+    NetWMID id,
+    std::vector<winsys::Window>& windowlist,
+    std::vector<winsys::Window> const& windowlist_
+)
+{
+    if (windowlist_ == windowlist)
+        return;
+
+    if (windowlist_.empty())
+        unset_windowlist_property(window, id);
+    else if (windowlist_.size() > windowlist.size()
+        && std::equal(windowlist.begin(), windowlist.end(), windowlist_.begin()))
+    {
+        std::for_each(
+            windowlist_.begin() + windowlist.size(),
+            windowlist_.end(),
+            [&,this](winsys::Window window__) {
+                append_windowlist_property(window, id, window__);
+            }
+        );
+    } else
+        replace_windowlist_property(window, id, windowlist_);
+
+    windowlist = windowlist_;
+}
+
+void
+XConnection::unset_windowlist_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_WINDOW,
         32,
         PropModeReplace,
@@ -2484,18 +3725,19 @@ XConnection::has_string_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
-        0L, 8, False, get_atom("UTF8_STRING"),
+        0L, 8, False, get_netwm_atom(NetWMID::Utf8String),
         &returned_type, &_i, &n_items_returned,
         &_ul, &ucp) == Success
         && ucp && XFree(ucp)
-        && returned_type == get_atom("UTF8_STRING")
+        && returned_type == get_netwm_atom(NetWMID::Utf8String)
         && n_items_returned > 0
     );
 }
 
 std::string
-XConnection::get_string_property(winsys::Window window, std::string const& name)
+XConnection::get_string_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2504,12 +3746,13 @@ XConnection::get_string_property(winsys::Window window, std::string const& name)
     Atom _a = None;
     std::string str_{};
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 8, False,
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(NetWMID::Utf8String),
         &_a, &_i, &n, &_ul,
         &ucp
     );
@@ -2524,13 +3767,13 @@ XConnection::get_string_property(winsys::Window window, std::string const& name)
 }
 
 void
-XConnection::replace_string_property(winsys::Window window, std::string const& name, std::string const& str_)
+XConnection::replace_string_property(winsys::Window window, NetWMID id, std::string const& str_)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(id),
+        get_netwm_atom(NetWMID::Utf8String),
         8,
         PropModeReplace,
         reinterpret_cast<const unsigned char*>(str_.c_str()),
@@ -2539,13 +3782,13 @@ XConnection::replace_string_property(winsys::Window window, std::string const& n
 }
 
 void
-XConnection::unset_string_property(winsys::Window window, std::string const& name)
+XConnection::unset_string_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(id),
+        get_netwm_atom(NetWMID::Utf8String),
         8,
         PropModeReplace,
         reinterpret_cast<const unsigned char*>(0),
@@ -2562,18 +3805,19 @@ XConnection::has_stringlist_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
-        0L, 8, False, get_atom("UTF8_STRING"),
+        0L, 8, False, get_netwm_atom(NetWMID::Utf8String),
         &returned_type, &_i, &n_items_returned,
         &_ul, &ucp) == Success
         && ucp && XFree(ucp)
-        && returned_type == get_atom("UTF8_STRING")
+        && returned_type == get_netwm_atom(NetWMID::Utf8String)
         && n_items_returned > 0
     );
 }
 
 std::vector<std::string>
-XConnection::get_stringlist_property(winsys::Window window, std::string const& name)
+XConnection::get_stringlist_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2582,12 +3826,13 @@ XConnection::get_stringlist_property(winsys::Window window, std::string const& n
     Atom _a = None;
     std::vector<std::string> stringlist{};
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 8, False,
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(NetWMID::Utf8String),
         &_a, &_i, &n, &_ul,
         &ucp
     );
@@ -2604,7 +3849,7 @@ XConnection::get_stringlist_property(winsys::Window window, std::string const& n
 }
 
 void
-XConnection::replace_stringlist_property(winsys::Window window, std::string const& name, std::vector<std::string> const& stringlist)
+XConnection::replace_stringlist_property(winsys::Window window, NetWMID id, std::vector<std::string> const& stringlist)
 {
     static char buffer[1024];
 
@@ -2629,8 +3874,8 @@ append:
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(id),
+        get_netwm_atom(NetWMID::Utf8String),
         8,
         PropModeAppend,
         reinterpret_cast<const unsigned char*>(buffer),
@@ -2639,7 +3884,7 @@ append:
 }
 
 void
-XConnection::append_stringlist_property(winsys::Window window, std::string const& name, std::string const& str_)
+XConnection::append_stringlist_property(winsys::Window window, NetWMID id, std::string const& str_)
 {
     static char buffer[1024];
 
@@ -2656,8 +3901,8 @@ XConnection::append_stringlist_property(winsys::Window window, std::string const
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(id),
+        get_netwm_atom(NetWMID::Utf8String),
         8,
         PropModeAppend,
         reinterpret_cast<const unsigned char*>(buffer),
@@ -2666,13 +3911,13 @@ XConnection::append_stringlist_property(winsys::Window window, std::string const
 }
 
 void
-XConnection::unset_stringlist_property(winsys::Window window, std::string const& name)
+XConnection::unset_stringlist_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
-        get_atom("UTF8_STRING"),
+        get_netwm_atom(id),
+        get_netwm_atom(NetWMID::Utf8String),
         8,
         PropModeReplace,
         reinterpret_cast<const unsigned char*>(0),
@@ -2689,6 +3934,7 @@ XConnection::has_card_property(winsys::Window window, Atom atom)
     Atom returned_type = None;
     unsigned long n_items_returned = 0;
 
+    report_round_trip("GetProperty");
     return (XGetWindowProperty(mp_dpy, window, atom,
         0L, 32, False, XA_CARDINAL,
         &returned_type, &_i, &n_items_returned,
@@ -2700,7 +3946,7 @@ XConnection::has_card_property(winsys::Window window, Atom atom)
 }
 
 unsigned long
-XConnection::get_card_property(winsys::Window window, std::string const& name)
+XConnection::get_card_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2709,10 +3955,11 @@ XConnection::get_card_property(winsys::Window window, std::string const& name)
     Atom _a = None;
     unsigned long card = None;
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_CARDINAL,
         &_a, &_i, &n, &_ul,
@@ -2729,12 +3976,12 @@ XConnection::get_card_property(winsys::Window window, std::string const& name)
 }
 
 void
-XConnection::replace_card_property(winsys::Window window, std::string const& name, unsigned long card)
+XConnection::replace_card_property(winsys::Window window, NetWMID id, unsigned long card)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_CARDINAL,
         32,
         PropModeReplace,
@@ -2744,12 +3991,12 @@ XConnection::replace_card_property(winsys::Window window, std::string const& nam
 }
 
 void
-XConnection::unset_card_property(winsys::Window window, std::string const& name)
+XConnection::unset_card_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_CARDINAL,
         32,
         PropModeReplace,
@@ -2759,7 +4006,7 @@ XConnection::unset_card_property(winsys::Window window, std::string const& name)
 }
 
 std::vector<unsigned long>
-XConnection::get_cardlist_property(winsys::Window window, std::string const& name)
+XConnection::get_cardlist_property(winsys::Window window, NetWMID id)
 {
     int _i;
     unsigned long n;
@@ -2768,10 +4015,11 @@ XConnection::get_cardlist_property(winsys::Window window, std::string const& nam
     Atom _a = None;
     std::vector<unsigned long> cardlist{};
 
+    report_round_trip("GetProperty");
     m_property_status = XGetWindowProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         0L, 32, False,
         XA_CARDINAL,
         &_a, &_i, &n, &_ul,
@@ -2790,12 +4038,12 @@ XConnection::get_cardlist_property(winsys::Window window, std::string const& nam
 }
 
 void
-XConnection::replace_cardlist_property(winsys::Window window, std::string const& name, std::vector<unsigned long> const& cardlist)
+XConnection::replace_cardlist_property(winsys::Window window, NetWMID id, std::vector<unsigned long> const& cardlist)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_CARDINAL,
         32,
         PropModeReplace,
@@ -2805,12 +4053,12 @@ XConnection::replace_cardlist_property(winsys::Window window, std::string const&
 }
 
 void
-XConnection::append_cardlist_property(winsys::Window window, std::string const& name, unsigned long card)
+XConnection::append_cardlist_property(winsys::Window window, NetWMID id, unsigned long card)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_CARDINAL,
         32,
         PropModeAppend,
@@ -2820,12 +4068,12 @@ XConnection::append_cardlist_property(winsys::Window window, std::string const&
 }
 
 void
-XConnection::unset_cardlist_property(winsys::Window window, std::string const& name)
+XConnection::unset_cardlist_property(winsys::Window window, NetWMID id)
 {
     XChangeProperty(
         mp_dpy,
         window,
-        get_atom(name),
+        get_netwm_atom(id),
         XA_CARDINAL,
         32,
         PropModeReplace,
@@ -2846,6 +4094,7 @@ XConnection::get_text_property(winsys::Window window, Atom atom, char* text, uns
 
     text[0] = '\0';
 
+    report_round_trip("GetProperty");
     if (!XGetTextProperty(mp_dpy, window, &name, atom) || !name.nitems)
         return false;
 
@@ -2863,11 +4112,62 @@ XConnection::get_text_property(winsys::Window window, Atom atom, char* text, uns
     return true;
 }
 
+bool
+XConnection::is_unmanaged_window_type(winsys::EnumSet<winsys::WindowType> const& types)
+{
+    static const std::vector<winsys::WindowType> ignore_types{
+        winsys::WindowType::Desktop,
+        winsys::WindowType::Dock,
+        winsys::WindowType::Toolbar,
+        winsys::WindowType::Menu,
+        winsys::WindowType::Splash,
+        winsys::WindowType::DropdownMenu,
+        winsys::WindowType::PopupMenu,
+        winsys::WindowType::Tooltip,
+        winsys::WindowType::Notification,
+        winsys::WindowType::Combo,
+        winsys::WindowType::Dnd,
+    };
+
+    return std::any_of(
+        ignore_types.begin(),
+        ignore_types.end(),
+        [&types](winsys::WindowType type) -> bool {
+            return types.count(type) > 0;
+        }
+    );
+}
+
+bool
+XConnection::is_free_window(
+    std::optional<Index> desktop,
+    winsys::EnumSet<winsys::WindowState> const& states,
+    winsys::EnumSet<winsys::WindowType> const& types,
+    std::optional<winsys::SizeHints> const& sh
+)
+{
+    if ((desktop && *desktop == 0xFFFFFFFF)
+        || states.count(winsys::WindowState::Modal) > 0
+        || types.count(winsys::WindowType::Dialog) > 0
+        || types.count(winsys::WindowType::Utility) > 0)
+    {
+        return true;
+    }
+
+    if (sh) {
+        if (sh->min_width && sh->min_height && sh->max_width && sh->max_height)
+            return *sh->max_width > 0 && *sh->max_height > 0
+                && *sh->max_width == *sh->min_width && *sh->max_height == *sh->min_height;
+    }
+
+    return false;
+}
+
 bool
 XConnection::window_is_any_of_states(winsys::Window window, std::vector<winsys::WindowState> const& free_states)
 {
     std::vector<Atom> window_state_atoms
-        = get_atomlist_property(window, "_NET_WM_STATE");
+        = get_atomlist_property(window, NetWMID::NetWMState);
 
     if (!property_status_ok())
         return false;
@@ -2903,7 +4203,7 @@ bool
 XConnection::window_is_any_of_types(winsys::Window window, std::vector<winsys::WindowType> const& free_types)
 {
     std::vector<Atom> window_type_atoms
-        = get_atomlist_property(window, "_NET_WM_WINDOW_TYPE");
+        = get_atomlist_property(window, NetWMID::NetWMWindowType);
 
     if (!property_status_ok())
         return false;
@@ -2948,6 +4248,11 @@ XConnection::on_button_press()
     winsys::Window window = event.window;
     winsys::Window subwindow = event.subwindow;
 
+    // presses caught by a frame's synchronous grab are handed on to the
+    // client straight away; the window manager only needs to see them
+    if (window != m_root && window != None)
+        XAllowEvents(mp_dpy, ReplayPointer, event.time);
+
     bool on_root = false;
     if (window == m_root && subwindow == None)
         on_root = true;
@@ -2988,7 +4293,7 @@ XConnection::on_button_press()
         }
     };
 
-    std::unordered_set<winsys::Modifier> modifiers{};
+    winsys::EnumSet<winsys::Modifier> modifiers{};
     for (auto& x11_modifier : x11_modifiers)
         if ((event.state & x11_modifier) > 0)
             modifiers.insert(x11_to_modifier(x11_modifier));
@@ -3058,7 +4363,7 @@ XConnection::on_button_release()
         }
     };
 
-    std::unordered_set<winsys::Modifier> modifiers{};
+    winsys::EnumSet<winsys::Modifier> modifiers{};
     for (auto& x11_modifier : x11_modifiers)
         if ((event.state & x11_modifier) > 0)
             modifiers.insert(x11_to_modifier(x11_modifier));
@@ -3403,7 +4708,7 @@ XConnection::on_key_press()
         }
     };
 
-    std::unordered_set<winsys::Modifier> modifiers{};
+    winsys::EnumSet<winsys::Modifier> modifiers{};
     for (auto& x11_modifier : x11_modifiers)
         if ((event.state & x11_modifier) != 0)
             modifiers.insert(x11_to_modifier(x11_modifier));
@@ -3447,8 +4752,30 @@ winsys::Event
 XConnection::on_mapping_notify()
 {
     XMappingEvent event = m_current_event.xmapping;
-    if (event.request == MappingKeyboard)
-        XRefreshKeyboardMapping(&event);
+    if (event.request != MappingKeyboard)
+        return std::monostate{};
+
+    XRefreshKeyboardMapping(&event);
+
+    std::array<KeyCode, winsys::KEY_COUNT> previous_keycodes = m_keycodes;
+    update_keyboard_mapping(event.first_keycode, event.count);
+
+    // only the grabs of keys that moved to another keycode are reissued; all
+    // stale grabs are released before any new ones are made, as a key may
+    // have moved to a keycode another one has just vacated
+    for (auto const& [key, modifiers] : m_key_grabs) {
+        std::size_t i = static_cast<std::size_t>(key);
+
+        if (m_keycodes[i] != previous_keycodes[i])
+            ungrab_key(previous_keycodes[i], modifiers);
+    }
+
+    for (auto const& [key, modifiers] : m_key_grabs) {
+        std::size_t i = static_cast<std::size_t>(key);
+
+        if (m_keycodes[i] != previous_keycodes[i])
+            grab_key(m_keycodes[i], modifiers);
+    }
 
     return std::monostate{};
 }
@@ -3456,8 +4783,6 @@ XConnection::on_mapping_notify()
 winsys::Event
 XConnection::on_motion_notify()
 {
-    last_typed_event(m_current_event, MotionNotify);
-
     XMotionEvent event = m_current_event.xmotion;
     winsys::Window window = event.window;
     winsys::Window subwindow = event.subwindow;
@@ -3490,7 +4815,7 @@ XConnection::on_motion_notify()
         }
     };
 
-    std::unordered_set<winsys::Modifier> modifiers{};
+    winsys::EnumSet<winsys::Modifier> modifiers{};
     for (auto& x11_modifier : x11_modifiers)
         if ((event.state & x11_modifier) != 0)
             modifiers.insert(x11_to_modifier(x11_modifier));
@@ -3541,7 +4866,7 @@ XConnection::on_property_notify()
         };
         }
 
-        if (event.atom == get_atom("_NET_WM_NAME")) {
+        if (event.atom == get_netwm_atom(NetWMID::NetWMName)) {
             return winsys::PropertyEvent {
                 window,
                 winsys::PropertyKind::Name,
@@ -3550,8 +4875,8 @@ XConnection::on_property_notify()
         }
     }
 
-    if (event.atom == get_atom("_NET_WM_STRUT_PARTIAL")
-        || event.atom == get_atom("_NET_WM_STRUT"))
+    if (event.atom == get_netwm_atom(NetWMID::NetWMStrutPartial)
+        || event.atom == get_netwm_atom(NetWMID::NetWMStrut))
     {
         return winsys::PropertyEvent {
             window,
@@ -3578,9 +4903,27 @@ XConnection::on_unmap_notify()
 winsys::Event
 XConnection::on_screen_change()
 {
+    XRRUpdateConfiguration(&m_current_event);
+
     return winsys::ScreenChangeEvent {};
 }
 
+winsys::Event
+XConnection::on_sync_alarm()
+{
+    XSyncAlarmNotifyEvent* event
+        = reinterpret_cast<XSyncAlarmNotifyEvent*>(&m_current_event);
+
+    auto window = m_sync_alarms.find(event->alarm);
+
+    if (window == m_sync_alarms.end())
+        return std::monostate{};
+
+    return winsys::SyncEvent {
+        window->second
+    };
+}
+
 winsys::Event
 XConnection::on_unimplemented()
 {
@@ -5,22 +5,27 @@
 #include "../event.hh"
 #include "../input.hh"
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 
 extern "C" {
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/Xmd.h>
+#include <X11/Xutil.h>
 #include <X11/cursorfont.h>
+#include <X11/extensions/sync.h>
 #include <sys/un.h>
 }
 
-class XConnection final: public winsys::Connection
+class XConnection: public winsys::Connection
 {
 public:
     XConnection(const std::string_view);
@@ -30,9 +35,12 @@ public:
     virtual bool flush() override;
     virtual winsys::Event step() override;
     virtual bool check_progress() override;
-    virtual void process_events(std::function<void(winsys::Event)>) override;
-    virtual void process_messages(std::function<void(winsys::Message)>) override;
+    virtual void process_events(std::function<void(winsys::Event)> const&) override;
+    virtual void process_messages(std::function<void(winsys::Message)> const&) override;
+    virtual void watch_fd(int, std::function<void()>) override;
+    virtual void unwatch_fd(int) override;
     virtual std::vector<winsys::Screen> connected_outputs() override;
+    virtual unsigned get_refresh_rate() override;
     virtual std::vector<winsys::Window> top_level_windows() override;
     virtual winsys::Pos get_pointer_position() override;
     virtual void warp_pointer_center_of_window_or_root(std::optional<winsys::Window>, winsys::Screen&) override;
@@ -40,12 +48,13 @@ public:
     virtual void warp_pointer_rpos(winsys::Window, winsys::Pos) override;
     virtual void confine_pointer(winsys::Window) override;
     virtual bool release_pointer() override;
-    virtual void call_external_command(std::string&) override;
     virtual void cleanup() override;
 
     // window manipulation
     virtual winsys::Window create_frame(winsys::Region) override;
+    virtual void release_frame(winsys::Window) override;
     virtual void init_window(winsys::Window) override;
+    virtual bool init_sync_request(winsys::Window) override;
     virtual void init_frame(winsys::Window, bool) override;
     virtual void init_unmanaged(winsys::Window) override;
     virtual void init_move(winsys::Window) override;
@@ -61,26 +70,27 @@ public:
     virtual void place_window(winsys::Window, winsys::Region&) override;
     virtual void move_window(winsys::Window, winsys::Pos) override;
     virtual void resize_window(winsys::Window, winsys::Dim) override;
+    virtual void send_sync_request(winsys::Window) override;
     virtual void focus_window(winsys::Window) override;
     virtual void stack_window_above(winsys::Window, std::optional<winsys::Window>) override;
     virtual void stack_window_below(winsys::Window, std::optional<winsys::Window>) override;
     virtual void insert_window_in_save_set(winsys::Window) override;
     virtual void grab_bindings(std::vector<winsys::KeyInput>&, std::vector<winsys::MouseInput>&) override;
-    virtual void regrab_buttons(winsys::Window) override;
-    virtual void ungrab_buttons(winsys::Window) override;
     virtual void unfocus() override;
     virtual void set_window_border_width(winsys::Window, unsigned) override;
     virtual void set_window_border_color(winsys::Window, unsigned) override;
     virtual void set_window_background_color(winsys::Window, unsigned) override;
     virtual void set_window_notify_enter(Window, bool) override;
-    virtual void update_window_offset(winsys::Window, winsys::Window) override;
+    virtual void update_window_offset(winsys::Window, winsys::Region) override;
+    virtual void update_window_offsets(std::vector<std::pair<winsys::Window, winsys::Region>> const&) override;
     virtual winsys::Window get_focused_window() override;
     virtual std::optional<winsys::Region> get_window_geometry(winsys::Window) override;
     virtual std::optional<winsys::Pid> get_window_pid(winsys::Window) override;
-    virtual std::optional<winsys::Pid> get_ppid(std::optional<winsys::Pid>) override;
     virtual bool must_manage_window(winsys::Window) override;
     virtual bool must_free_window(winsys::Window) override;
     virtual bool window_is_mappable(winsys::Window) override;
+    virtual winsys::WindowSnapshot fetch_window_snapshot(winsys::Window) override;
+    virtual std::vector<winsys::WindowSnapshot> fetch_window_snapshots(std::vector<winsys::Window> const&) override;
 
     // ICCCM
     virtual void set_icccm_window_state(winsys::Window, winsys::IcccmWindowState) override;
@@ -109,8 +119,8 @@ public:
     virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut(winsys::Window) override;
     virtual std::optional<std::vector<std::optional<winsys::Strut>>> get_window_strut_partial(winsys::Window) override;
     virtual std::optional<Index> get_window_desktop(winsys::Window) override;
-    virtual std::unordered_set<winsys::WindowType> get_window_types(winsys::Window) override;
-    virtual std::unordered_set<winsys::WindowState> get_window_states(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowType> get_window_types(winsys::Window) override;
+    virtual winsys::EnumSet<winsys::WindowState> get_window_states(winsys::Window) override;
     virtual bool window_is_fullscreen(winsys::Window) override;
     virtual bool window_is_above(winsys::Window) override;
     virtual bool window_is_below(winsys::Window) override;
@@ -119,11 +129,55 @@ public:
     // IPC client
     virtual void init_for_client() override;
 
-private:
+    struct SuppressedRequests final
+    {
+        std::size_t geometry;
+        std::size_t border_width;
+        std::size_t border_color;
+        std::size_t background_color;
+        std::size_t event_mask;
+        std::size_t map_state;
+        std::size_t offset;
+    };
+
+    SuppressedRequests const& suppressed_requests() const;
+
+    struct CompactedEvents final
+    {
+        std::size_t batch;
+        std::size_t configure_requests;
+        std::size_t crossings;
+        std::size_t destroyed;
+        std::size_t properties;
+        std::size_t motions;
+    };
+
+    CompactedEvents const& compacted_events() const;
+
+protected:
     static int s_otherwm_error_handler(Display*, XErrorEvent*);
     static int s_passthrough_error_handler(Display*, XErrorEvent*);
     static int s_default_error_handler(Display*, XErrorEvent*);
 
+    // events are served by class: input first and in full, then a bounded
+    // quantum of structural and background work, so that a flooding client
+    // cannot hold up key and button handling
+    enum class EventClass
+    {
+        Input,
+        Structural,
+        Background
+    };
+
+    static constexpr std::size_t STRUCTURAL_QUANTUM = 8;
+    static constexpr std::size_t BACKGROUND_QUANTUM = 16;
+
+    // events held in the batch at most; beyond it, events are left to Xlib
+    static constexpr std::size_t MAX_EVENT_BACKLOG = 1024;
+
+    static winsys::Window event_window(XEvent const&);
+    static EventClass event_class(XEvent const&);
+
     enum NetWMID : int
     { // NetWM atom identifiers
         NetSupported = 0, NetFirst = NetSupported,
@@ -143,6 +197,8 @@ private:
         NetSupportingWMCheck,
         NetWMState,
         NetWMWindowType,
+        NetWMSyncRequest,
+        NetWMSyncRequestCounter,
         // root messages
         NetWMCloseWindow, NetWMRootFirst = NetWMCloseWindow,
         NetWMMoveResize,
@@ -167,7 +223,28 @@ private:
         NetWMWindowTypeTooltip,
         NetWMWindowTypeNotification,
         NetWMWindowTypeNormal, NetWMwindowtypelast = NetWMWindowTypeNormal,
-        NetLast
+        NetLast,
+        // in use, but not advertised as supported
+        NetClientListStacking = NetLast,
+        NetWMPid,
+        NetWMStateModal,
+        NetWMStateSticky,
+        NetWMStateMaximizedVert,
+        NetWMStateMaximizedHorz,
+        NetWMStateShaded,
+        NetWMStateSkipTaskbar,
+        NetWMStateSkipPager,
+        NetWMWindowTypeCombo,
+        NetWMWindowTypeDnd,
+        // ICCCM
+        WMName,
+        WMClass,
+        WMState,
+        WMProtocols,
+        WMDeleteWindow,
+        WMClientLeader,
+        Utf8String,
+        AtomLast
     };
 
     enum class NetWMAction
@@ -191,9 +268,13 @@ private:
     int m_dpy_fd;
     int m_sock_fd;
     int m_client_fd;
-    int m_max_fd;
+    int m_epoll_fd;
+
+    bool m_dpy_ready;
+    bool m_sock_ready;
+
+    std::unordered_map<int, std::function<void()>> m_fd_watchers;
 
-	fd_set m_descr;
 	char m_sock_path[256];
 	char m_state_path[256] = {};
 	struct sockaddr_un m_sock_addr;
@@ -209,13 +290,89 @@ private:
 
     std::optional<winsys::Window> m_confined_to;
 
-    std::unordered_map<std::string, Atom> m_interned_atoms;
-    std::unordered_map<Atom, std::string> m_atom_names;
 
-    std::unordered_map<std::size_t, winsys::Key> m_keys;
-    std::unordered_map<winsys::Key, std::size_t> m_keycodes;
+    // the keyboard mapping as last retrieved from the server, with the keys
+    // and keycodes derived from it, and the key grabs that follow its changes
+    std::vector<KeySym> m_keyboard_mapping;
+    int m_min_keycode;
+    int m_keysyms_per_keycode;
+    std::array<winsys::Key, 256> m_keys;
+    std::array<KeyCode, winsys::KEY_COUNT> m_keycodes;
+    std::vector<std::pair<winsys::Key, unsigned>> m_key_grabs;
+
+    std::array<Atom, NetWMID::AtomLast> m_netwm_atoms;
+
+    std::vector<winsys::Window> m_client_list;
+    std::vector<winsys::Window> m_client_list_stacking;
+
+    // the 32-bit visual and colormap shared by all frames, and released
+    // frames that are kept around for reuse
+    static constexpr std::size_t FRAME_POOL_SIZE = 16;
 
-    std::unordered_map<NetWMID, Atom> m_netwm_atoms;
+    Visual* mp_frame_visual = nullptr;
+    int m_frame_depth = CopyFromParent;
+    Colormap m_frame_colormap = None;
+    std::vector<winsys::Window> m_frame_pool;
+
+    // the update counters of clients that take part in _NET_WM_SYNC_REQUEST,
+    // each with an alarm that reports when the client has caught up
+    struct SyncCounter final
+    {
+        XSyncCounter counter;
+        XSyncAlarm alarm;
+        std::int64_t value;
+    };
+
+    bool m_sync_available = false;
+    int m_sync_event_base = 0;
+    std::unordered_map<winsys::Window, SyncCounter> m_sync_counters;
+    std::unordered_map<XSyncAlarm, winsys::Window> m_sync_alarms;
+
+    bool m_randr_available = false;
+    int m_randr_event_base = 0;
+
+    // PIDs resolved ahead of time for a batch of windows being adopted
+    std::unordered_map<winsys::Window, std::optional<winsys::Pid>> m_prefetched_pids;
+
+    // server-side state as last observed through events or our own requests;
+    // updates carrying a serial older than the last request we issued for a
+    // window are stale and ignored
+    struct WindowShadow final
+    {
+        unsigned long serial;
+        std::optional<winsys::Region> region;
+        std::optional<bool> mapped;
+        std::optional<unsigned> border_width;
+        std::optional<unsigned> border_color;
+        std::optional<unsigned> background_color;
+        std::optional<long> event_mask;
+        std::optional<winsys::Region> offset;
+    };
+
+    std::unordered_map<winsys::Window, WindowShadow> m_window_shadows;
+    std::optional<winsys::Window> m_focus_shadow;
+    unsigned long m_focus_serial = 0;
+    std::optional<winsys::Pos> m_pointer_shadow;
+
+    bool m_handling_event = false;
+    std::size_t m_round_trips = 0;
+
+    SuppressedRequests m_suppressed_requests{};
+
+    // events read off the queue but not yet dispatched, compacted whenever
+    // more are read, and the serials of our own requests that may move
+    // windows underneath the pointer; dispatched and eliminated events are
+    // retyped as spent until they are removed
+    static constexpr int SPENT_EVENT = 0;
+
+    std::vector<XEvent> m_event_batch;
+    std::optional<std::size_t> m_scheduled_event = std::nullopt;
+    std::unordered_set<winsys::Window> m_batch_blocked;
+    std::vector<unsigned long> m_crossing_serials;
+    std::vector<winsys::Window> m_batch_destroyed;
+    std::vector<std::pair<winsys::Window, Atom>> m_batch_properties;
+    std::vector<std::pair<winsys::Window, std::size_t>> m_batch_configures;
+    CompactedEvents m_compacted_events{};
 
     int (*m_checkwm_error_handler)(Display*, XErrorEvent*);
 
@@ -233,6 +390,13 @@ private:
         return event;
     }
 
+    void track_window(winsys::Window);
+    void untrack_window(winsys::Window);
+    WindowShadow* get_shadow(winsys::Window);
+    WindowShadow* write_shadow(winsys::Window);
+    void update_shadows(XEvent const&);
+    void report_round_trip(const char*);
+
     void enable_substructure_events();
     void disable_substructure_events();
 
@@ -240,21 +404,37 @@ private:
     bool typed_event(XEvent&, int);
     void last_typed_event(XEvent&, int);
 
+    void read_event_batch();
+    void compact_event_batch();
+    void dispatch_events(std::function<void(winsys::Event)> const&, EventClass, std::size_t);
+    void note_crossing_request();
+    void fence_crossing_requests();
+
     void sync(bool);
     int pending();
 
     winsys::Window create_handle();
 
-    Atom get_atom(std::string const&);
+    bool init_sync_alarm(winsys::Window, XSyncCounter);
+    bool init_sync_alarm(winsys::Window, XSyncCounter, XSyncValue);
+    void prefetch_pids(std::vector<winsys::Window> const&);
+
     Atom get_netwm_atom(NetWMID const&);
-    void intern_atom(std::string const&, Atom);
 
     winsys::Key get_key(const std::size_t);
     std::size_t get_keycode(const winsys::Key);
-    void intern_key(const unsigned, const winsys::Key);
+    KeySym get_keysym(const winsys::Key) const;
+    void load_keyboard_mapping();
+    void update_keyboard_mapping(int, int);
+    void index_keys();
+    void grab_key(KeyCode, unsigned);
+    void ungrab_key(KeyCode, unsigned);
     winsys::Button get_button(const unsigned) const;
     unsigned get_buttoncode(const winsys::Button) const;
 
+    std::optional<winsys::Hints> get_hints_from_wmhints(XWMHints const&) const;
+    std::optional<winsys::SizeHints> get_size_hints_from_sizehints(XSizeHints const&, std::optional<winsys::Dim>) const;
+
     winsys::WindowState get_window_state_from_atom(Atom);
     winsys::WindowType get_window_type_from_atom(Atom);
     Atom get_atom_from_window_state(winsys::WindowState);
@@ -271,39 +451,49 @@ private:
     bool has_card_property(winsys::Window, Atom);
     bool has_cardlist_property(winsys::Window, Atom);
 
-    Atom get_atom_property(winsys::Window, std::string const&);
-    std::vector<Atom> get_atomlist_property(winsys::Window, std::string const&);
-    winsys::Window get_window_property(winsys::Window, std::string const&);
-    std::vector<winsys::Window> get_windowlist_property(winsys::Window, std::string const&);
-    std::string get_string_property(winsys::Window, std::string const&);
-    std::vector<std::string> get_stringlist_property(winsys::Window, std::string const&);
-    unsigned long get_card_property(winsys::Window, std::string const&);
-    std::vector<unsigned long> get_cardlist_property(winsys::Window, std::string const&);
+    Atom get_atom_property(winsys::Window, NetWMID);
+    std::vector<Atom> get_atomlist_property(winsys::Window, NetWMID);
+    winsys::Window get_window_property(winsys::Window, NetWMID);
+    std::vector<winsys::Window> get_windowlist_property(winsys::Window, NetWMID);
+    std::string get_string_property(winsys::Window, NetWMID);
+    std::vector<std::string> get_stringlist_property(winsys::Window, NetWMID);
+    unsigned long get_card_property(winsys::Window, NetWMID);
+    std::vector<unsigned long> get_cardlist_property(winsys::Window, NetWMID);
 
     bool get_text_property(winsys::Window, Atom, char*, unsigned);
 
-    void replace_atom_property(winsys::Window, std::string const&, Atom);
-    void replace_atomlist_property(winsys::Window, std::string const&, std::vector<Atom> const&);
-    void replace_window_property(winsys::Window, std::string const&, winsys::Window);
-    void replace_windowlist_property(winsys::Window, std::string const&, std::vector<winsys::Window> const&);
-    void replace_string_property(winsys::Window, std::string const&, std::string const&);
-    void replace_stringlist_property(winsys::Window, std::string const&, std::vector<std::string> const&);
-    void replace_card_property(winsys::Window, std::string const&, const unsigned long);
-    void replace_cardlist_property(winsys::Window, std::string const&, std::vector<unsigned long> const&);
-
-    void append_atomlist_property(winsys::Window, std::string const&, Atom);
-    void append_windowlist_property(winsys::Window, std::string const&, winsys::Window);
-    void append_stringlist_property(winsys::Window, std::string const&, std::string const&);
-    void append_cardlist_property(winsys::Window, std::string const&, const unsigned long);
-
-    void unset_atom_property(winsys::Window, std::string const&);
-    void unset_atomlist_property(winsys::Window, std::string const&);
-    void unset_window_property(winsys::Window, std::string const&);
-    void unset_windowlist_property(winsys::Window, std::string const&);
-    void unset_string_property(winsys::Window, std::string const&);
-    void unset_stringlist_property(winsys::Window, std::string const&);
-    void unset_card_property(winsys::Window, std::string const&);
-    void unset_cardlist_property(winsys::Window, std::string const&);
+    void replace_atom_property(winsys::Window, NetWMID, Atom);
+    void replace_atomlist_property(winsys::Window, NetWMID, std::vector<Atom> const&);
+    void replace_window_property(winsys::Window, NetWMID, winsys::Window);
+    void replace_windowlist_property(winsys::Window, NetWMID, std::vector<winsys::Window> const&);
+    void replace_string_property(winsys::Window, NetWMID, std::string const&);
+    void replace_stringlist_property(winsys::Window, NetWMID, std::vector<std::string> const&);
+    void replace_card_property(winsys::Window, NetWMID, const unsigned long);
+    void replace_cardlist_property(winsys::Window, NetWMID, std::vector<unsigned long> const&);
+
+    void append_atomlist_property(winsys::Window, NetWMID, Atom);
+    void append_windowlist_property(winsys::Window, NetWMID, winsys::Window);
+    void append_stringlist_property(winsys::Window, NetWMID, std::string const&);
+    void append_cardlist_property(winsys::Window, NetWMID, const unsigned long);
+
+    void update_windowlist_property(winsys::Window, NetWMID, std::vector<winsys::Window>&, std::vector<winsys::Window> const&);
+
+    void unset_atom_property(winsys::Window, NetWMID);
+    void unset_atomlist_property(winsys::Window, NetWMID);
+    void unset_window_property(winsys::Window, NetWMID);
+    void unset_windowlist_property(winsys::Window, NetWMID);
+    void unset_string_property(winsys::Window, NetWMID);
+    void unset_stringlist_property(winsys::Window, NetWMID);
+    void unset_card_property(winsys::Window, NetWMID);
+    void unset_cardlist_property(winsys::Window, NetWMID);
+
+    static bool is_unmanaged_window_type(winsys::EnumSet<winsys::WindowType> const&);
+    static bool is_free_window(
+        std::optional<Index>,
+        winsys::EnumSet<winsys::WindowState> const&,
+        winsys::EnumSet<winsys::WindowType> const&,
+        std::optional<winsys::SizeHints> const&
+    );
 
     bool window_is_any_of_states(winsys::Window, std::vector<winsys::WindowState> const&);
     bool window_is_any_of_types(winsys::Window, std::vector<winsys::WindowType> const&);
@@ -330,6 +520,7 @@ private:
     winsys::Event on_motion_notify();
     winsys::Event on_property_notify();
     winsys::Event on_screen_change();
+    winsys::Event on_sync_alarm();
     winsys::Event on_unmap_notify();
 
     winsys::Event on_unimplemented();